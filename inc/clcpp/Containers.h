@@ -59,6 +59,14 @@ namespace clcpp
 
 		// Move onto the next value in the container
 		virtual void MoveNext() = 0;
+
+		// If the values from the current iterator position to the end of the container are stored
+		// contiguously, return a pointer to the first and their count so that they can be processed
+		// in bulk. Returns false if the container's storage isn't contiguous.
+		virtual bool GetContiguous(const void*& data, unsigned int& count) const
+		{
+			return false;
+		}
 	};
 
 
@@ -71,19 +79,28 @@ namespace clcpp
 		virtual ~IWriteIterator() { }
 
 		// One-time initialisation of the iterator that should initialise its own internal
-		// values and write back what it knows of the container to WriteIterator. Use the count
-		// parameter to pre-allocate all the values that need writing.
+		// values and write back what it knows of the container to WriteIterator. The count
+		// parameter is a hint of the number of values that will be written, which can be used
+		// to reserve storage up-front. It's zero when the number of values isn't known in advance.
 		virtual void Initialise(const Primitive* primitive, void* container_object, WriteIterator& storage, int count) = 0;
 
 		// Allocate an empty value in the container at the current iterator position and return
 		// a pointer to that value so that it can be written to. Moves onto the next value after
-		// the call.
+		// the call. Dynamic containers must grow to accommodate values beyond the count hint.
 		virtual void* AddEmpty() = 0;
 
 		// Allocate an empty value with the given key object at the current iterator position
 		// and return a pointer to that value so that it can be written to. Moves onto the next
 		// value after the call.
 		virtual void* AddEmpty(void* key) = 0;
+
+		// Allocate count contiguous empty values at the current iterator position and return a
+		// pointer to the first so that they can be written in bulk, moving past all of them. Returns
+		// null without adding any values if the container's storage isn't contiguous.
+		virtual void* AddEmptyContiguous(unsigned int count)
+		{
+			return 0;
+		}
 	};
 
 
@@ -142,6 +159,10 @@ namespace clcpp
 		{
 			((IReadIterator*)m_ImplData)->MoveNext();
 		}
+		bool GetContiguous(const void*& data, unsigned int& count) const
+		{
+			return ((IReadIterator*)m_ImplData)->GetContiguous(data, count);
+		}
 	};
 
 
@@ -154,8 +175,9 @@ namespace clcpp
 		WriteIterator();
 		~WriteIterator();
 
-		// Construct from a template type with the number of elements you're going to write
-		void Initialise(const TemplateType* type, void* container_object, int count);
+		// Construct from a template type with the number of elements you're going to write, if
+		// known. Leave the count as zero to grow the container with each added element.
+		void Initialise(const TemplateType* type, void* container_object, int count = 0);
 
 		// Construct from a field; can only be used to construct write iterators for
 		// C-Array fields.
@@ -172,6 +194,10 @@ namespace clcpp
 		{
 			return ((IWriteIterator*)m_ImplData)->AddEmpty(key);
 		}
+		void* AddEmptyContiguous(unsigned int count)
+		{
+			return ((IWriteIterator*)m_ImplData)->AddEmptyContiguous(count);
+		}
 
 	private:
 		bool m_Initialised;
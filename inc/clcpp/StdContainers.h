@@ -0,0 +1,340 @@
+
+//
+// ===============================================================================
+// clReflect, StdContainers.h - Container iterators for the standard library's
+// std::vector, std::map and std::unordered_map.
+// -------------------------------------------------------------------------------
+// Copyright (c) 2011-2012 Don Williamson & clReflect Authors (see AUTHORS file)
+// Released under MIT License (see LICENSE file)
+// ===============================================================================
+//
+
+#pragma once
+
+
+#include "Containers.h"
+
+#include <vector>
+#include <map>
+
+
+//
+// Checking for C++11 library support, which allows map values to be emplaced and brings
+// std::unordered_map with it
+//
+#if __cplusplus >= 201103L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201103L)
+	#define CLCPP_USING_STD_CPP11
+	#include <unordered_map>
+	#include <tuple>
+	#include <utility>
+#endif // __cplusplus
+
+
+//
+// Iterator implementations can only be bound to a container by name so these templates have
+// to be instantiated as a unique class for every container type that's reflected. This is
+// done with the clcpp_std_vector_iterators and clcpp_std_map_iterators macros from the global
+// namespace, which also register the iterators with the container:
+//
+//    typedef std::map<int, float> IntFloatMap;
+//    clcpp_std_vector_iterators(IntVector, std::vector<int>, "std::vector<int,std::allocator<int>>")
+//    clcpp_std_map_iterators(IntFloatMap, IntFloatMap, "<name of IntFloatMap in the database>")
+//
+// The first parameter is the prefix for the names of the <name>ReadIterator/<name>WriteIterator
+// classes that are created. The container type must be a typedef if it contains commas and the
+// last parameter is the name of the template instance as it appears in the database, including
+// any default template arguments. The clReflectScan AST log lists these names.
+//
+// std::vector<bool> isn't supported as it doesn't store its values as addressable bools.
+//
+// Of the serialisers, only JSON supports these containers. Maps are saved as arrays of
+// [key,value] pairs, as their keys needn't be strings, and maps with pointer keys are saved
+// empty. The versioned binary serialisers only support C-array fields.
+//
+namespace clcpp
+{
+	namespace internal
+	{
+		// Containers that support it can reserve storage for the values that will be written
+		template <typename CONTAINER_TYPE>
+		inline void ReserveStd(CONTAINER_TYPE& container, int count)
+		{
+		}
+		template <typename VALUE_TYPE, typename ALLOC_TYPE>
+		inline void ReserveStd(std::vector<VALUE_TYPE, ALLOC_TYPE>& container, int count)
+		{
+			container.reserve(count);
+		}
+
+	#ifdef CLCPP_USING_STD_CPP11
+		template <typename KEY_TYPE, typename VALUE_TYPE, typename HASH_TYPE, typename EQUAL_TYPE, typename ALLOC_TYPE>
+		inline void ReserveStd(std::unordered_map<KEY_TYPE, VALUE_TYPE, HASH_TYPE, EQUAL_TYPE, ALLOC_TYPE>& container, int count)
+		{
+			container.reserve(count);
+		}
+	#endif
+	}
+
+
+	//
+	// Read iterator for std::vector, which exposes the values as a single contiguous run
+	//
+	template <typename VECTOR_TYPE>
+	class StdVectorReadIterator : public IReadIterator
+	{
+	public:
+		StdVectorReadIterator()
+			: m_Vector(0)
+			, m_Position(0)
+		{
+		}
+
+		void Initialise(const Primitive* primitive, const void* container_object, ReadIterator& storage)
+		{
+			internal::Assert(primitive != 0);
+			internal::Assert(container_object != 0);
+
+			// Describe the value type from the template arguments
+			internal::Assert(primitive->kind == Primitive::KIND_TEMPLATE_TYPE);
+			const TemplateType* template_type = (const TemplateType*)primitive;
+			storage.m_ValueType = template_type->parameter_types[0];
+			storage.m_ValueIsPtr = template_type->parameter_ptrs[0];
+
+			m_Vector = (const VECTOR_TYPE*)container_object;
+			m_Position = 0;
+			storage.m_Count = (unsigned int)m_Vector->size();
+		}
+
+		ContainerKeyValue GetKeyValue() const
+		{
+			internal::Assert(m_Position < m_Vector->size());
+			ContainerKeyValue kv;
+			kv.value = &(*m_Vector)[m_Position];
+			return kv;
+		}
+
+		void MoveNext()
+		{
+			m_Position++;
+		}
+
+		bool GetContiguous(const void*& data, unsigned int& count) const
+		{
+			internal::Assert(m_Position <= m_Vector->size());
+			count = (unsigned int)(m_Vector->size() - m_Position);
+			data = count ? &(*m_Vector)[m_Position] : 0;
+			return true;
+		}
+
+	private:
+		const VECTOR_TYPE* m_Vector;
+		typename VECTOR_TYPE::size_type m_Position;
+	};
+
+
+	//
+	// Write iterator for std::vector that replaces the vector contents, reserving storage
+	// for the count hint so that values can be added without reallocation
+	//
+	template <typename VECTOR_TYPE>
+	class StdVectorWriteIterator : public IWriteIterator
+	{
+	public:
+		StdVectorWriteIterator()
+			: m_Vector(0)
+		{
+		}
+
+		void Initialise(const Primitive* primitive, void* container_object, WriteIterator& storage, int count)
+		{
+			internal::Assert(primitive != 0);
+			internal::Assert(container_object != 0);
+
+			// Describe the value type from the template arguments
+			internal::Assert(primitive->kind == Primitive::KIND_TEMPLATE_TYPE);
+			const TemplateType* template_type = (const TemplateType*)primitive;
+			storage.m_ValueType = template_type->parameter_types[0];
+			storage.m_ValueIsPtr = template_type->parameter_ptrs[0];
+
+			m_Vector = (VECTOR_TYPE*)container_object;
+			m_Vector->clear();
+			internal::ReserveStd(*m_Vector, count);
+			storage.m_Count = count;
+		}
+
+		void* AddEmpty()
+		{
+		#ifdef CLCPP_USING_STD_CPP11
+			m_Vector->emplace_back();
+		#else
+			m_Vector->push_back(typename VECTOR_TYPE::value_type());
+		#endif
+			return &m_Vector->back();
+		}
+
+		void* AddEmpty(void* key)
+		{
+			return AddEmpty();
+		}
+
+		void* AddEmptyContiguous(unsigned int count)
+		{
+			// Value-initialise all new values in one go
+			typename VECTOR_TYPE::size_type size = m_Vector->size();
+			m_Vector->resize(size + count);
+			return count ? &(*m_Vector)[size] : 0;
+		}
+
+	private:
+		VECTOR_TYPE* m_Vector;
+	};
+
+
+	//
+	// Read iterator for std::map and std::unordered_map, returning pointers to each
+	// key and its mapped value
+	//
+	template <typename MAP_TYPE>
+	class StdMapReadIterator : public IReadIterator
+	{
+	public:
+		StdMapReadIterator()
+			: m_Map(0)
+		{
+		}
+
+		void Initialise(const Primitive* primitive, const void* container_object, ReadIterator& storage)
+		{
+			internal::Assert(primitive != 0);
+			internal::Assert(container_object != 0);
+
+			// Describe the key and value types from the template arguments
+			internal::Assert(primitive->kind == Primitive::KIND_TEMPLATE_TYPE);
+			const TemplateType* template_type = (const TemplateType*)primitive;
+			storage.m_KeyType = template_type->parameter_types[0];
+			storage.m_KeyIsPtr = template_type->parameter_ptrs[0];
+			storage.m_ValueType = template_type->parameter_types[1];
+			storage.m_ValueIsPtr = template_type->parameter_ptrs[1];
+
+			m_Map = (const MAP_TYPE*)container_object;
+			m_Position = m_Map->begin();
+			storage.m_Count = (unsigned int)m_Map->size();
+		}
+
+		ContainerKeyValue GetKeyValue() const
+		{
+			internal::Assert(m_Position != m_Map->end());
+			ContainerKeyValue kv;
+			kv.key = &m_Position->first;
+			kv.value = &m_Position->second;
+			return kv;
+		}
+
+		void MoveNext()
+		{
+			++m_Position;
+		}
+
+	private:
+		const MAP_TYPE* m_Map;
+		typename MAP_TYPE::const_iterator m_Position;
+	};
+
+
+	//
+	// Write iterator for std::map and std::unordered_map that replaces the map contents.
+	// Values are constructed in-place next to a copy of their key and, as maps are read
+	// back in the order they were written, each is inserted with a hint at the end of the
+	// map to make sorted insertion amortised constant-time.
+	//
+	template <typename MAP_TYPE>
+	class StdMapWriteIterator : public IWriteIterator
+	{
+	public:
+		StdMapWriteIterator()
+			: m_Map(0)
+		{
+		}
+
+		void Initialise(const Primitive* primitive, void* container_object, WriteIterator& storage, int count)
+		{
+			internal::Assert(primitive != 0);
+			internal::Assert(container_object != 0);
+
+			// Describe the key and value types from the template arguments
+			internal::Assert(primitive->kind == Primitive::KIND_TEMPLATE_TYPE);
+			const TemplateType* template_type = (const TemplateType*)primitive;
+			storage.m_KeyType = template_type->parameter_types[0];
+			storage.m_KeyIsPtr = template_type->parameter_ptrs[0];
+			storage.m_ValueType = template_type->parameter_types[1];
+			storage.m_ValueIsPtr = template_type->parameter_ptrs[1];
+
+			m_Map = (MAP_TYPE*)container_object;
+			m_Map->clear();
+			internal::ReserveStd(*m_Map, count);
+			storage.m_Count = count;
+		}
+
+		void* AddEmpty()
+		{
+			// Maps can't be written without keys
+			internal::Assert(false);
+			return 0;
+		}
+
+		void* AddEmpty(void* key)
+		{
+			internal::Assert(key != 0);
+			const typename MAP_TYPE::key_type& key_object = *(const typename MAP_TYPE::key_type*)key;
+		#ifdef CLCPP_USING_STD_CPP11
+			typename MAP_TYPE::iterator i = m_Map->emplace_hint(m_Map->end(),
+				std::piecewise_construct, std::forward_as_tuple(key_object), std::forward_as_tuple());
+		#else
+			typename MAP_TYPE::iterator i = m_Map->insert(m_Map->end(),
+				typename MAP_TYPE::value_type(key_object, typename MAP_TYPE::mapped_type()));
+		#endif
+			return &i->second;
+		}
+
+	private:
+		MAP_TYPE* m_Map;
+	};
+}
+
+
+//
+// Registers container iterators by the exact name of the container in the database
+//
+#ifdef __clcpp_parse__
+	#define clcpp_std_container_info(container_name, read_iterator, write_iterator, keyinfo)				\
+		clcpp_reflect_part(read_iterator)																	\
+		clcpp_reflect_part(write_iterator)																	\
+		namespace clcpp_internal																			\
+		{																									\
+			struct																							\
+			__attribute__((annotate("container-" container_name "-" #read_iterator "-" #write_iterator "-" #keyinfo)))	\
+			CLCPP_UNIQUE(container_info) { };																\
+		}
+#else
+	#define clcpp_std_container_info(container_name, read_iterator, write_iterator, keyinfo)
+#endif
+
+
+//
+// Creates uniquely named iterator classes for a container type, along with the construction
+// functions needed to create them at runtime, and registers them with the container
+//
+#define clcpp_std_iterators(name, container_type, container_name, read_template, write_template, keyinfo)	\
+	class name##ReadIterator : public clcpp::read_template< container_type > { };							\
+	class name##WriteIterator : public clcpp::write_template< container_type > { };						\
+	clcpp_impl_class(name##ReadIterator)																	\
+	clcpp_impl_class(name##WriteIterator)																	\
+	clcpp_std_container_info(container_name, name##ReadIterator, name##WriteIterator, keyinfo)
+
+
+#define clcpp_std_vector_iterators(name, container_type, container_name)	\
+	clcpp_std_iterators(name, container_type, container_name, StdVectorReadIterator, StdVectorWriteIterator, nokey)
+
+
+#define clcpp_std_map_iterators(name, container_type, container_name)	\
+	clcpp_std_iterators(name, container_type, container_name, StdMapReadIterator, StdMapWriteIterator, haskey)
@@ -66,6 +66,22 @@
 #endif // CLCPP_USING_MSVC
 
 
+//
+// Checking for C++14 constexpr support, which allows names to be hashed at compile-time
+//
+#if __cplusplus >= 201402L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)
+	#define CLCPP_USING_CONSTEXPR
+#endif // __cplusplus
+
+
+//
+// Define CLCPP_COMPACT_LAYOUT to use a smaller memory map on 64-bit platforms. Arrays
+// drop their allocator pointer, primitive arrays find their name hashes directly after
+// their data and primitives don't point back to their database. The database must be
+// exported by a clexport built with the same setting (CL_REFLECT_COMPACT_LAYOUT in CMake).
+//
+
+
 //
 // Generate a unique symbol with the given prefix
 //
@@ -344,8 +360,84 @@ namespace clcpp
 		unsigned HashData(const void* data, int length, unsigned int seed = 0);
 
 
+	#if defined(CLCPP_USING_CONSTEXPR)
+
+		//
+		// MurmurHash 3 of a string of known length, identical to HashData on little-endian
+		// platforms but able to be evaluated at compile-time
+		//
+		constexpr unsigned int HashNameChars(const char* chars, int length, unsigned int seed = 0)
+		{
+			const unsigned int c1 = 0xcc9e2d51;
+			const unsigned int c2 = 0x1b873593;
+			unsigned int h1 = seed;
+
+			// Body
+			int pos = 0;
+			for (; pos + 4 <= length; pos += 4)
+			{
+				unsigned int k1 = (unsigned char)chars[pos] | (unsigned char)chars[pos + 1] << 8 | (unsigned char)chars[pos + 2] << 16 | (unsigned int)(unsigned char)chars[pos + 3] << 24;
+				k1 *= c1;
+				k1 = (k1 << 15) | (k1 >> 17);
+				k1 *= c2;
+				h1 ^= k1;
+				h1 = (h1 << 13) | (h1 >> 19);
+				h1 = h1 * 5 + 0xe6546b64;
+			}
+
+			// Tail
+			unsigned int k1 = 0;
+			int tail = length & 3;
+			if (tail == 3)
+				k1 ^= (unsigned char)chars[pos + 2] << 16;
+			if (tail >= 2)
+				k1 ^= (unsigned char)chars[pos + 1] << 8;
+			if (tail >= 1)
+			{
+				k1 ^= (unsigned char)chars[pos];
+				k1 *= c1;
+				k1 = (k1 << 15) | (k1 >> 17);
+				k1 *= c2;
+				h1 ^= k1;
+			}
+
+			// Finalisation
+			h1 ^= length;
+			h1 ^= h1 >> 16;
+			h1 *= 0x85ebca6b;
+			h1 ^= h1 >> 13;
+			h1 *= 0xc2b2ae35;
+			h1 ^= h1 >> 16;
+			return h1;
+		}
+
+
 		//
-		// Hashes the full string into a 32-bit value
+		// Compile-time equivalent of HashNameString, for CLCPP_NAME_HASH
+		//
+		constexpr unsigned int ConstHashNameString(const char* name_string, unsigned int seed = 0)
+		{
+			int length = 0;
+			while (name_string[length])
+				length++;
+			return HashNameChars(name_string, length, seed);
+		}
+
+
+		//
+		// Forces a name hash to be evaluated at compile-time
+		//
+		template <unsigned int HASH> struct ConstantHash
+		{
+			static const unsigned int value = HASH;
+		};
+
+	#endif
+
+
+		//
+		// Hashes the full string into a 32-bit value. This is always defined out-of-line so that
+		// the library can be linked with code compiled with any language standard.
 		//
 		unsigned int HashNameString(const char* name_string, unsigned int seed = 0);
 
@@ -374,7 +466,12 @@ namespace clcpp
 	//
 	template <typename TYPE> struct CArray
 	{
-		CArray() : size(0), data(0), allocator(0)
+		CArray()
+			: size(0)
+			, data(0)
+		#if !defined(CLCPP_COMPACT_LAYOUT)
+			, allocator(0)
+		#endif
 		{
 		}
 
@@ -391,7 +488,11 @@ namespace clcpp
 
 		unsigned int size;
 		TYPE* data;
+
+	#if !defined(CLCPP_COMPACT_LAYOUT)
+		// Unused by the runtime and always null within a loaded database
 		IAllocator* allocator;
+	#endif
 	};
 
 
@@ -404,6 +505,11 @@ namespace clcpp
 		// Derived classes must implement just the read function, returning
 		// true on success, false otherwise.
 		virtual bool Read(void* dest, size_type size) = 0;
+
+		// Optionally, move the read position to an offset from the start of the database
+		// file. This allows database sections to be skipped and loaded on demand. Files
+		// that can't seek have all database sections loaded up-front.
+		virtual bool Seek(size_type offset) { return false; }
 	};
 
 
@@ -419,6 +525,18 @@ namespace clcpp
 }
 
 
+//
+// Hash of a name as used throughout the database, such as "reflect" or "Namespace::Class".
+// With C++14 compilers this is a compile-time constant, otherwise the hash is calculated
+// on each call and should be stored in a local static.
+//
+#if defined(CLCPP_USING_CONSTEXPR)
+	#define CLCPP_NAME_HASH(name) (clcpp::internal::ConstantHash<clcpp::internal::ConstHashNameString(name)>::value)
+#else
+	#define CLCPP_NAME_HASH(name) clcpp::internal::HashNameString(name)
+#endif
+
+
 
 // ===============================================================================
 //                    Runtime, Read-Only Reflection Database API
@@ -439,6 +557,7 @@ namespace clcpp
 	namespace internal
 	{
 		struct DatabaseMem;
+		struct DatabaseSections;
 
 		//
 		// All primitive arrays are sorted in order of increasing name hash. This will perform an
@@ -451,9 +570,47 @@ namespace clcpp
 		// primitives - useful for searching primitives with names that can be overloaded.
 		//
 		Range FindOverloadedPrimitive(const CArray<const Primitive*>& primitives, unsigned int hash);
+
+		//
+		// Searches an array of name hashes, sorted in increasing order, for the index of the
+		// first occurrence of the hash. Returns -1 if the hash can't be found.
+		//
+		int FindHashIndex(const unsigned int* hashes, unsigned int nb_hashes, unsigned int hash);
 	}
 
 
+	//
+	// Array of primitive pointers sorted by name hash, with a parallel array of the hashes so
+	// that searches only have to touch contiguous memory, dereferencing a primitive on a hit.
+	// The hashes are null for an empty array.
+	//
+	template <typename TYPE> struct PrimitiveArray : public CArray<const TYPE*>
+	{
+	#if defined(CLCPP_COMPACT_LAYOUT)
+
+		// The hash array is stored directly after the primitive pointers
+		const unsigned int* GetHashes() const
+		{
+			return this->size ? (const unsigned int*)(this->data + this->size) : 0;
+		}
+
+	#else
+
+		PrimitiveArray() : hashes(0)
+		{
+		}
+
+		const unsigned int* GetHashes() const
+		{
+			return hashes;
+		}
+
+		const unsigned int* hashes;
+
+	#endif
+	};
+
+
 	//
 	// A descriptive text name with a unique 32-bit hash value for mapping primitives.
 	//
@@ -551,8 +708,10 @@ namespace clcpp
 		Name name;
 		const Primitive* parent;
 
-		// Database this primitive belongs to
+		// Database this primitive belongs to, which isn't recorded in the compact layout
+	#if !defined(CLCPP_COMPACT_LAYOUT)
 		Database* database;
+	#endif
 	};
 
 
@@ -647,6 +806,20 @@ namespace clcpp
 		// Does this type derive from the specified type, by hash?
 		bool DerivesFrom(unsigned int type_name_hash) const;
 
+		// Constant-time check to see if this type is, or derives from, the specified type
+		bool IsA(const Type* type) const
+		{
+			// Types that reach the specified type through their first base are within its interval
+			if (dfs_first >= type->dfs_first && dfs_first <= type->dfs_last)
+				return true;
+
+			// Any other ancestors are marked in the secondary base bit set
+			unsigned int index = type->secondary_base_index;
+			if (index-- == 0 || (index >> 5) >= secondary_bases.size)
+				return false;
+			return (secondary_bases.data[index >> 5] & (1U << (index & 31))) != 0;
+		}
+
 		// Safe utility functions for casting to derived types
 		const Enum* AsEnum() const;
 		const TemplateType* AsTemplateType() const;
@@ -660,6 +833,18 @@ namespace clcpp
 
 		// This is non-null if the type is a registered container
 		ContainerInfo* ci;
+
+		// Depth-first numbering of the inheritance forest formed by following the first base
+		// of each type. The range [dfs_first, dfs_last] covers this type and all types that
+		// derive from it through their first base.
+		unsigned int dfs_first;
+		unsigned int dfs_last;
+
+		// Types that are ancestors through anything but a chain of first bases, i.e. multiple
+		// inheritance, are given a non-zero index and set as bit (index - 1) in the bit set of
+		// all their descendants.
+		unsigned int secondary_base_index;
+		CArray<unsigned int> secondary_bases;
 	};
 
 
@@ -685,9 +870,26 @@ namespace clcpp
 
 		Enum();
 
+		// Returns the first constant, in name order, with the specified value or null if there
+		// is none. This is constant-time for enums with a compact range of values and O(logN)
+		// otherwise.
+		const EnumConstant* FindConstantByValue(int value) const;
+
 		// All sorted by name
-		CArray<const EnumConstant*> constants;
-		CArray<const Attribute*> attributes;
+		PrimitiveArray<EnumConstant> constants;
+		PrimitiveArray<Attribute> attributes;
+
+		// All constants sorted by value, with equal values kept in name order
+		CArray<const EnumConstant*> constants_by_value;
+
+		// If the constant values cover a compact range, this is indexed by the value less the
+		// base to directly find the constant for each value. Values with no constant are null.
+		int value_table_base;
+		CArray<const EnumConstant*> value_table;
+
+		// Enums with the "flags" attribute store the constant for each single-bit value here,
+		// indexed by bit, so that values can be decomposed into their flags
+		CArray<const EnumConstant*> flag_constants;
 
 		// Bits representing some of the flag attributes in the attribute array
 		unsigned int flag_attributes;
@@ -716,7 +918,7 @@ namespace clcpp
 		unsigned int parent_unique_id;
 
 		// All sorted by name
-		CArray<const Attribute*> attributes;
+		PrimitiveArray<Attribute> attributes;
 
 		// Bits representing some of the flag attributes in the attribute array
 		unsigned int flag_attributes;
@@ -748,8 +950,8 @@ namespace clcpp
 		const Field* return_parameter;
 
 		// All sorted by name
-		CArray<const Field*> parameters;
-		CArray<const Attribute*> attributes;
+		PrimitiveArray<Field> parameters;
+		PrimitiveArray<Attribute> attributes;
 
 		// Bits representing some of the flag attributes in the attribute array
 		unsigned int flag_attributes;
@@ -788,7 +990,7 @@ namespace clcpp
 		Template();
 
 		// All sorted by name
-		CArray<const TemplateType*> instances;
+		PrimitiveArray<TemplateType> instances;
 	};
 
 
@@ -805,12 +1007,17 @@ namespace clcpp
 		const Function* destructor;
 
 		// All sorted by name
-		CArray<const Enum*> enums;
-		CArray<const Class*> classes;
-		CArray<const Function*> methods;
-		CArray<const Field*> fields;
-		CArray<const Attribute*> attributes;
-		CArray<const Template*> templates;
+		PrimitiveArray<Enum> enums;
+		PrimitiveArray<Class> classes;
+		PrimitiveArray<Function> methods;
+		PrimitiveArray<Field> fields;
+		PrimitiveArray<Attribute> attributes;
+		PrimitiveArray<Template> templates;
+
+		// All fields of this class and its bases in declaration order; the fields of each base
+		// first, followed by the fields of this class sorted by offset. Inheriting from a
+		// container can't be flattened, leaving this empty.
+		CArray<const Field*> flattened_fields;
 
 		// Bits representing some of the flag attributes in the attribute array
 		unsigned int flag_attributes;
@@ -827,12 +1034,12 @@ namespace clcpp
 		Namespace();
 
 		// All sorted by name
-		CArray<const Namespace*> namespaces;
-		CArray<const Type*> types;
-		CArray<const Enum*> enums;
-		CArray<const Class*> classes;
-		CArray<const Function*> functions;
-		CArray<const Template*> templates;
+		PrimitiveArray<Namespace> namespaces;
+		PrimitiveArray<Type> types;
+		PrimitiveArray<Enum> enums;
+		PrimitiveArray<Class> classes;
+		PrimitiveArray<Function> functions;
+		PrimitiveArray<Template> templates;
 	};
 
 
@@ -857,6 +1064,41 @@ namespace clcpp
 	}
 
 
+	//
+	// Overloads for searching primitive arrays using their parallel hash arrays
+	//
+	template <typename TYPE>
+	inline const TYPE* FindPrimitive(const PrimitiveArray<TYPE>& primitives, unsigned int hash)
+	{
+		const unsigned int* hashes = primitives.GetHashes();
+		if (hashes == 0)
+			return FindPrimitive((const CArray<const TYPE*>&)primitives, hash);
+		int index = internal::FindHashIndex(hashes, primitives.size, hash);
+		if (index == -1)
+			return 0;
+		return primitives.data[index];
+	}
+	template <typename TYPE>
+	inline Range FindOverloadedPrimitive(const PrimitiveArray<TYPE>& primitives, unsigned int hash)
+	{
+		const unsigned int* hashes = primitives.GetHashes();
+		if (hashes == 0)
+			return FindOverloadedPrimitive((const CArray<const TYPE*>&)primitives, hash);
+
+		// The search returns the first match so only the hashes that follow need checking
+		Range range;
+		int index = internal::FindHashIndex(hashes, primitives.size, hash);
+		if (index != -1)
+		{
+			range.first = index;
+			range.last = index + 1;
+			while (range.last < primitives.size && hashes[range.last] == hash)
+				range.last++;
+		}
+		return range;
+	}
+
+
 	class clcpp_attr(reflect_part) Database
 	{
 	public:
@@ -868,12 +1110,52 @@ namespace clcpp
 			OPT_DONT_REBASE_FUNCTIONS = 0x00000001,
 		};
 
+		enum
+		{
+			// Sections of the database that can be loaded independently. Types, enums,
+			// classes, templates, namespaces and fields are always loaded.
+			SECTION_TYPES = 0x00000001,
+			SECTION_NAMES = 0x00000002,
+			SECTION_FUNCTIONS = 0x00000004,
+			SECTION_ATTRIBUTES = 0x00000008,
+			SECTION_ALL = 0x0000000F,
+		};
+
 		Database();
 		~Database();
 
 		bool Load(IFile* file, IAllocator* allocator, unsigned int options);
 		bool Load(IFile* file, IAllocator* allocator, pointer_type base_address, unsigned int options);
 
+		// Load only the database sections in the mask, deferring the rest until they're first
+		// accessed through the database (GetName, GetFunction) or requested with LoadSections.
+		// Sections that loaded primitives point into, such as the attributes and methods of
+		// classes, are always loaded with them; only names and unreferenced functions and
+		// attributes are left deferred.
+		// The file must be seekable and has to outlive the database if any section is deferred.
+		// Until the names are loaded, name text is null.
+		bool Load(IFile* file, IAllocator* allocator, pointer_type base_address, unsigned int options, unsigned int sections);
+
+		// The base address that function addresses are rebased to when none is given to Load
+		static pointer_type GetModuleLoadAddress();
+
+		// Load any deferred sections in the mask, returning false if they can't be loaded.
+		// This isn't thread-safe, including when called implicitly on first access.
+		bool LoadSections(unsigned int sections) const;
+		unsigned int GetLoadedSections() const;
+
+		// Use the contents of a database file directly, without copying or relocating any pointers.
+		// This requires a file exported with a prelinked base address (clexport -cpp_base) that has
+		// been memory-mapped at that address; use GetInPlaceLoadAddress to find out where that is.
+		// The file data is never written to so it can be shared, read-only, between processes.
+		// The file data must outlive the database and Primitive::database is left null.
+		bool LoadInPlace(const void* file_data, size_type file_size, unsigned int options);
+
+		// Reads the header of a database file and returns the address that the start of the file
+		// must be mapped at for LoadInPlace to succeed. Returns zero if the file can't be loaded
+		// in-place.
+		static pointer_type GetInPlaceLoadAddress(IFile* file);
+
 		// This returns the name as it exists in the name database, with the text pointer
 		// pointing to within the database's allocated name data
 		Name GetName(unsigned int hash) const;
@@ -905,8 +1187,11 @@ namespace clcpp
 
 		internal::DatabaseMem* m_DatabaseMem;
 
-		// Allocator used to load the database
+		// Allocator used to load the database, null when loaded in-place
 		IAllocator* m_Allocator;
+
+		// Section memory and the relocation data needed to load deferred sections
+		internal::DatabaseSections* m_Sections;
 	};
 };
 
@@ -927,7 +1212,94 @@ namespace clcpp
 	//
 	// THIS IMPLEMENTATION IS CURRENTLY IN DEVELOPMENT AND AWAITING FURTHER DOCUMENTATION
 	//
+	// Defining CLCPP_COMPILER_TYPE_NAMES implements GetTypeNameHash at compile-time from the
+	// compiler's own spelling of each type name, removing the need for the implementation
+	// generated by clmerge. Names are spelt the same as clReflect for all but template types
+	// on some compilers, where the generated implementation should be used instead.
 	//
+	//
+#if defined(CLCPP_COMPILER_TYPE_NAMES)
+	template <typename TYPE> constexpr unsigned int GetTypeNameHash();
+#else
 	template <typename TYPE> unsigned int GetTypeNameHash();
+#endif
 	template <typename TYPE> const Type* GetType();
 }
+
+
+#if defined(CLCPP_COMPILER_TYPE_NAMES)
+
+#if !defined(CLCPP_USING_CONSTEXPR)
+	#error CLCPP_COMPILER_TYPE_NAMES requires a C++14 compiler
+#endif
+
+
+namespace clcpp
+{
+	namespace internal
+	{
+		//
+		// Returns the position of text within the string, or -1 if it can't be found
+		//
+		constexpr int FindText(const char* string, const char* text)
+		{
+			for (int i = 0; string[i]; i++)
+			{
+				int j = 0;
+				while (text[j] && string[i + j] == text[j])
+					j++;
+				if (text[j] == 0)
+					return i;
+			}
+			return -1;
+		}
+
+
+		//
+		// Skips any elaborated type specifier MSVC prefixes the type name with
+		//
+		constexpr int SkipTypeKeyword(const char* name)
+		{
+			const char* keywords[] = { "class ", "struct ", "enum ", "union " };
+			for (int i = 0; i < 4; i++)
+			{
+				int length = 0;
+				while (keywords[i][length] && name[length] == keywords[i][length])
+					length++;
+				if (keywords[i][length] == 0)
+					return length;
+			}
+			return 0;
+		}
+
+
+		//
+		// Hashes the type name found within the compiler-generated signature of this function
+		//
+		template <typename TYPE> constexpr unsigned int GetCompilerTypeNameHash()
+		{
+		#if defined(CLCPP_USING_MSVC)
+			// unsigned int __cdecl clcpp::internal::GetCompilerTypeNameHash<class NAME>(void)
+			const char* signature = __FUNCSIG__;
+			int start = FindText(signature, "GetCompilerTypeNameHash<") + 24;
+			start += SkipTypeKeyword(signature + start);
+			int end = FindText(signature, ">(void)");
+		#else
+			// GCC:   constexpr unsigned int clcpp::internal::GetCompilerTypeNameHash() [with TYPE = NAME]
+			// clang: unsigned int clcpp::internal::GetCompilerTypeNameHash() [TYPE = NAME]
+			const char* signature = __PRETTY_FUNCTION__;
+			int start = FindText(signature, "TYPE = ") + 7;
+			int end = start + FindText(signature + start, "]");
+		#endif
+			return HashNameChars(signature + start, end - start);
+		}
+	}
+
+
+	template <typename TYPE> constexpr unsigned int GetTypeNameHash()
+	{
+		return internal::ConstantHash<internal::GetCompilerTypeNameHash<TYPE>()>::value;
+	}
+}
+
+#endif
@@ -1,4 +1,6 @@
 
+#pragma once
+
 #include "clcpp.h"
 
 
@@ -6,6 +8,48 @@ namespace clcpp
 {
 	namespace internal
 	{
+		//
+		// Minimal perfect hash table, built offline, for constant-time lookup of entries in
+		// a hash-sorted array. Keys are distributed among buckets and each bucket stores a
+		// seed that displaces all its keys to unique slots. Keys that aren't in the table
+		// map to arbitrary entries so a hit must always be verified by comparing hashes.
+		//
+		struct HashTable
+		{
+			static unsigned int GetBucket(unsigned int hash, unsigned int nb_buckets)
+			{
+				return (unsigned int)(((clcpp::uint64)hash * nb_buckets) >> 32);
+			}
+
+			static unsigned int GetSlot(unsigned int hash, unsigned int seed, unsigned int nb_slots)
+			{
+				// Finalisation mix of the seeded hash before reducing it to the slot range
+				unsigned int h = hash ^ seed;
+				h ^= h >> 16;
+				h *= 0x85ebca6b;
+				h ^= h >> 13;
+				h *= 0xc2b2ae35;
+				h ^= h >> 16;
+				return (unsigned int)(((clcpp::uint64)h * nb_slots) >> 32);
+			}
+
+			// Returns the index of the only entry that can have the given hash or -1 if the table is empty
+			int Find(unsigned int hash) const
+			{
+				if (indices.size == 0)
+					return -1;
+				unsigned int seed = seeds.data[GetBucket(hash, seeds.size)];
+				return indices.data[GetSlot(hash, seed, indices.size)];
+			}
+
+			// Displacement seed for each bucket
+			CArray<unsigned int> seeds;
+
+			// Index of the entry in the source array, for each slot
+			CArray<unsigned int> indices;
+		};
+
+
 		//
 		// Memory-mapped representation of the entire reflection database
 		//
@@ -50,11 +94,78 @@ namespace clcpp
 			// A list of all registered containers
 			CArray<ContainerInfo> container_infos;
 
+			// Perfect hash tables for constant-time name hash lookup in the sorted arrays
+			HashTable name_table;
+			HashTable type_primitive_table;
+			HashTable function_table;
+			HashTable template_table;
+			HashTable namespace_table;
+
 			// The root namespace that allows you to reach every referenced primitive
 			Namespace global_namespace;
 		};
 
 
+		//
+		// Each section of the memory map is loaded and relocated independently
+		//
+		enum DatabaseSectionIndex
+		{
+			// The database object, all types, their fields and scope arrays
+			DATABASE_SECTION_TYPES,
+
+			// Name text and the name lookup table
+			DATABASE_SECTION_NAMES,
+
+			// Functions, their parameter arrays and the function lookup table
+			DATABASE_SECTION_FUNCTIONS,
+
+			// Attribute objects and text attribute data
+			DATABASE_SECTION_ATTRIBUTES,
+
+			NB_DATABASE_SECTIONS
+		};
+
+
+		//
+		// Location of a section within the memory map and the relocation instructions that
+		// patch pointers within it
+		//
+		struct DatabaseSection
+		{
+			clcpp::size_type data_offset;
+			clcpp::size_type data_size;
+			int first_ptr_relocation;
+			int nb_ptr_relocations;
+
+			// Location of the section within the file, which differs from its location within
+			// the memory map when the file is compressed
+			clcpp::size_type file_offset;
+			clcpp::size_type file_size;
+		};
+
+
+		//
+		// Compressed files store the relocation data and each section as independent sequences
+		// of blocks, so that sections can still be seeked to and loaded on their own
+		//
+		enum
+		{
+			DATABASE_BLOCK_SIZE = 64 * 1024,
+			DATABASE_FLAG_COMPRESSED = 1,
+
+			// Set when exported with CLCPP_COMPACT_LAYOUT, which the runtime must match
+			DATABASE_FLAG_COMPACT_LAYOUT = 2,
+		};
+
+		struct DatabaseBlockHeader
+		{
+			// Blocks that didn't compress are stored as-is, with equal sizes
+			unsigned int compressed_size;
+			unsigned int data_size;
+		};
+
+
 		//
 		// Header for binary database file
 		//
@@ -69,13 +180,24 @@ namespace clcpp
 			unsigned int signature0;
 			unsigned int signature1;
 			unsigned int version;
+			unsigned int flags;
 
 			int nb_ptr_schemas;
 			int nb_ptr_offsets;
 			int nb_ptr_relocations;
+			int nb_ptr_links;
 
+			// Offset of the memory map from the start of the file, after all relocation data
+			clcpp::size_type data_offset;
 			clcpp::size_type data_size;
 
+			DatabaseSection sections[NB_DATABASE_SECTIONS];
+
+			// Address that all pointers in the memory map were prelinked against. This is zero
+			// for a position-dependent file that can only be loaded with relocation. When non-zero,
+			// a file mapped so that its memory map starts at this address can be used in-place.
+			clcpp::pointer_type data_base;
+
 			// TODO: CRC verify?
 		};
 	}
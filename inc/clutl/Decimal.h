@@ -0,0 +1,39 @@
+
+//
+// ===============================================================================
+// clReflect, Decimal.h - Conversion between floating point numbers and decimal
+// text, with shortest round-trip formatting and correctly rounded parsing.
+// -------------------------------------------------------------------------------
+// Copyright (c) 2011-2012 Don Williamson & clReflect Authors (see AUTHORS file)
+// Released under MIT License (see LICENSE file)
+// ===============================================================================
+//
+
+#pragma once
+
+
+#include <clcpp/clcpp.h>
+
+
+namespace clutl
+{
+	// Large enough for any number written by FormatDouble or FormatFloat, such as "-2.2250738585072014e-308"
+	const unsigned int MAX_DECIMAL_CHARS = 32;
+
+
+	//
+	// Writes the shortest decimal that reads back as exactly the same value, returning the number of
+	// characters written. There is always a decimal point or exponent so that the number can't be
+	// mistaken for an integer. Infinities and NaNs are written as "inf", "-inf" and "nan".
+	//
+	unsigned int FormatDouble(char* dest, double value);
+	unsigned int FormatFloat(char* dest, float value);
+
+
+	//
+	// Parses a number of the form -?[0-9]+(\.[0-9]*)?([eE][+-]?[0-9]+)? from the start of the text,
+	// rounded correctly to the nearest double. Returns the number of characters parsed, or zero if
+	// the text doesn't start with a number.
+	//
+	unsigned int ParseDouble(const char* text, unsigned int length, double& value);
+}
@@ -109,6 +109,16 @@ namespace clutl
 		// Increment the current line for error reporting
 		void IncLine();
 
+		// Consume any whitespace ahead, counting the lines it spans
+		void SkipWhitespace();
+
+		// Count the characters ahead before the next quote, escape or the end of data
+		unsigned int StringRunLength();
+
+		// Empty buffer for decoding a string with escape sequences into. The lexer alternates between
+		// two buffers so that the previous string token stays valid while the next one is lexed.
+		clutl::WriteBuffer& NextStringBuffer();
+
 		void PushState(const clutl::JSONToken& token);
 		void PopState(clutl::JSONToken& token);
 
@@ -116,17 +126,40 @@ namespace clutl
 
 
 	private:
+		void IndexBlock(unsigned int position);
+
 		// Parsing state
 		clutl::ReadBuffer& m_ReadBuffer;
 		clutl::JSONError m_Error;
 		unsigned int m_Line;
 		unsigned int m_LinePosition;
 
+		// Structural index of the block of 64 characters starting at m_IndexPosition, with one bit
+		// for each character that's whitespace, a newline, or a quote or escape
+		unsigned int m_IndexPosition;
+		clcpp::uint64 m_WhitespaceMask;
+		clcpp::uint64 m_NewlineMask;
+		clcpp::uint64 m_StringMask;
+
+		// Decoded strings, only allocated when escape sequences are encountered
+		clutl::WriteBuffer m_StringBuffers[2];
+		unsigned int m_StringBufferIndex;
+
 		// One-level deep parsing state stack
 		unsigned int m_StackPosition;
 		clutl::JSONToken m_StackToken;
 	};
 
 
+	//
+	// Reads the next token from the context. String tokens point to the text between the quotes,
+	// directly in the data buffer when there are no escape sequences to decode. Otherwise they point
+	// to decoded UTF-8 text, which is only valid until the next-but-one string with escape sequences
+	// is lexed.
+	//
 	clutl::JSONToken LexerNextToken(clutl::JSONContext& ctx);
+
+
+	// Writes a string as the contents of a JSON string, escaping quotes, backslashes and control characters
+	void EscapeJSONString(clutl::WriteBuffer& out, const char* str, unsigned int length);
 }
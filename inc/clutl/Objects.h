@@ -71,6 +71,23 @@ namespace clobj
 			return type == clcpp::GetType<TYPE>() ? (TYPE*)this : 0;
 		}
 
+		// Cast that succeeds if the object's type is, or derives from, the specified type. Fails if
+		// the specified type isn't in the loaded database. The specified type must itself derive
+		// from Object, so that the cast can apply its base offset; IsA also accepts secondary
+		// bases that don't, and those won't compile.
+		template <typename TYPE>
+		TYPE* DynCast()
+		{
+			const clcpp::Type* cast_type = clcpp::GetType<TYPE>();
+			return type != 0 && cast_type != 0 && type->IsA(cast_type) ? static_cast<TYPE*>(this) : 0;
+		}
+		template <typename TYPE>
+		const TYPE* DynCast() const
+		{
+			const clcpp::Type* cast_type = clcpp::GetType<TYPE>();
+			return type != 0 && cast_type != 0 && type->IsA(cast_type) ? static_cast<const TYPE*>(this) : 0;
+		}
+
 		// Type of the object
 		const clcpp::Type* type;
 
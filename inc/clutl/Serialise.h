@@ -22,6 +22,16 @@ namespace clutl
 	class JSONContext;
 
 
+	//
+	// Destination that a WriteBuffer can flush its data to while it's still being written, such
+	// as a file or socket
+	//
+	struct IStreamSink
+	{
+		virtual void Write(const void* data, unsigned int length) = 0;
+	};
+
+
 	//
 	// Growable write byte buffer
 	//
@@ -30,6 +40,18 @@ namespace clutl
 	public:
 		WriteBuffer();
 		WriteBuffer(unsigned int initial_capacity);
+
+		// Reserves max_capacity bytes of address space without allocating any memory for it, committing
+		// memory in the range as the buffer grows. Growing never copies the data and pointers returned by
+		// Alloc remain valid for the life time of the buffer. Writing beyond max_capacity asserts.
+		// Platforms without virtual memory, or where the reservation fails, use a growable buffer instead.
+		WriteBuffer(unsigned int initial_capacity, unsigned int max_capacity);
+
+		// Flushes data to the sink in chunks of up to chunk_size bytes whenever the buffer fills, keeping
+		// only pinned data in memory. Call Flush after writing to send the remaining data to the sink.
+		// Save versioned binary data with VBinFlags::STREAMED to keep its memory use bounded.
+		WriteBuffer(IStreamSink* sink, unsigned int chunk_size);
+
 		~WriteBuffer();
 
 		// Resets only the write position, ensuring none of the capacity already allocated is released
@@ -49,8 +71,24 @@ namespace clutl
 
 		void SeekRel(int offset);
 
+		// Sends all data that isn't pinned to the sink, if there is one
+		void Flush();
+
+		// Keeps data written from the current position in memory, so that it can be patched with
+		// GetDataAt, until a matching Unpin. Pins can be nested.
+		void Pin() { if (m_NbPins++ == 0) m_PinPosition = GetBytesWritten(); }
+		void Unpin() { m_NbPins--; }
+
+		// Data still in memory at a position in the stream
+		char* GetDataAt(unsigned int position) { return m_Data + (position - m_BytesFlushed); }
+
+		// Data that hasn't been flushed
 		const char* GetData() const { return m_Data; }
-		unsigned int GetBytesWritten() const { return m_DataWrite - m_Data; }
+
+		// Positions in the stream, including any data that has been flushed
+		unsigned int GetBytesWritten() const { return m_BytesFlushed + (m_DataWrite - m_Data); }
+		unsigned int GetBytesFlushed() const { return m_BytesFlushed; }
+
 		unsigned int GetBytesAllocated() const { return m_DataEnd - m_Data; }
 
 	private:
@@ -58,9 +96,21 @@ namespace clutl
 		WriteBuffer(const WriteBuffer&);
 		WriteBuffer& operator= (const WriteBuffer&);
 
+		void Grow(unsigned int length);
+
 		char* m_Data;
 		char* m_DataEnd;
 		char* m_DataWrite;
+
+		// End of the reserved address range, or null if the buffer is allocated on the heap
+		char* m_DataReservedEnd;
+
+		IStreamSink* m_Sink;
+		unsigned int m_BytesFlushed;
+
+		// Position of the first pin, before which data can be flushed
+		unsigned int m_NbPins;
+		unsigned int m_PinPosition;
 	};
 
 
@@ -73,6 +123,10 @@ namespace clutl
 	public:
 		ReadBuffer(const WriteBuffer& write_buffer);
 
+		// Reads directly from external memory, such as a mapped file, without copying it. The memory
+		// must remain valid for the life time of the buffer.
+		ReadBuffer(const void* data, unsigned int size);
+
 		// TODO: Not entirely convinced by this API with regards to the ability of its users
 		//  to quickly, safely and easily detect buffer overflow scenarios before it asserts.
 		void Read(void* data, unsigned int length);
@@ -94,6 +148,41 @@ namespace clutl
 	};
 
 
+	//
+	// Read-only mapping of a file into memory so that it can be loaded with a ReadBuffer without
+	// first being copied:
+	//
+	//    clutl::MappedFile file;
+	//    if (file.Open("save.bin"))
+	//    {
+	//        clutl::ReadBuffer read_buffer(file.GetData(), file.GetSize());
+	//        ...
+	//    }
+	//
+	// Files larger than 4GB can't be mapped.
+	//
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		bool Open(const char* filename);
+		void Close();
+
+		const char* GetData() const { return m_Data; }
+		unsigned int GetSize() const { return m_Size; }
+
+	private:
+		// Disable copying
+		MappedFile(const MappedFile&);
+		MappedFile& operator= (const MappedFile&);
+
+		const char* m_Data;
+		unsigned int m_Size;
+	};
+
+
 	// TODO: Try to merge into one function to cut down on call overhead?
 	struct IPtrSave
 	{
@@ -104,9 +193,84 @@ namespace clutl
 	};
 
 
+	// Recreates the objects of a graph loaded from the versioned binary format
+	struct IPtrLoad
+	{
+		// Return the type an object was saved with, or null if it's no longer available
+		virtual const clcpp::Type* GetPtrType(unsigned int type_hash) = 0;
+
+		// Allocate and construct an object of the given type, or return null to skip it and
+		// leave any pointers to it null
+		virtual void* CreatePtr(const clcpp::Type* type) = 0;
+	};
+
+
+	struct VBinPlans;
+
+
+	//
+	// Every class is compiled once into a plan of operations that the versioned binary format
+	// then saves and loads objects of that class with. Plans last for the duration of a save
+	// or load call unless one of these caches is passed to each call, keeping them for reuse.
+	// A cache can't be shared between threads and must be destroyed before the database its
+	// classes belong to is unloaded.
+	//
+	class VBinPlanCache
+	{
+	public:
+		VBinPlanCache();
+		~VBinPlanCache();
+
+		// Plans are created on first use
+		VBinPlans& GetPlans();
+
+	private:
+		// Disable copying
+		VBinPlanCache(const VBinPlanCache&);
+		VBinPlanCache& operator= (const VBinPlanCache&);
+
+		VBinPlans* m_Plans;
+	};
+
+
+	struct VBinFlags
+	{
+		enum
+		{
+			// Replaces the 12-byte header of each field with an index into a table of the fields of each
+			// class, written once at the end of the data, and writes all sizes, counts and pointer
+			// references as variable-length integers. Containers of values with a fixed size don't store
+			// a size with each value. Loading detects this encoding automatically.
+			COMPACT = 0x01,
+
+			// Splits the data into frames of half the WriteBuffer's capacity or 256 bytes, whichever is
+			// larger, each followed by the sizes of chunks that started in an earlier frame. A WriteBuffer
+			// streaming to a sink can then flush every frame but the one being written. Frames can overrun
+			// by the largest value or contiguous container written in one go. Can't be combined with COMPACT.
+			// Loading detects this encoding automatically.
+			STREAMED = 0x02,
+		};
+	};
+
+
 	// Binary serialisation
-	void SaveVersionedBinary(WriteBuffer& out, const void* object, const clcpp::Type* type);
-	void LoadVersionedBinary(ReadBuffer& in, void* object, const clcpp::Type* type);
+	// Pointers accepted by ptr_save's CanSavePtr have the objects they point to saved once, after the
+	// object itself, no matter how many times they're referenced. Objects deriving from clobj::Object
+	// are saved with their runtime type. When loading, ptr_load creates each of these objects and all
+	// loaded pointers are patched to point at them once the graph has been read.
+	// If ptr_save/ptr_load is null, no pointers are serialised.
+	// Pass plan_cache to reuse the plans compiled for each class between calls.
+	void SaveVersionedBinary(WriteBuffer& out, const void* object, const clcpp::Type* type, IPtrSave* ptr_save = 0, VBinPlanCache* plan_cache = 0, unsigned int flags = 0);
+	void LoadVersionedBinary(ReadBuffer& in, void* object, const clcpp::Type* type, IPtrLoad* ptr_load = 0, VBinPlanCache* plan_cache = 0);
+
+	// Snapshot serialisation, for saving and restoring objects within the same build
+	// Classes made from nothing but primitive values, enums, C-Arrays of them and other such classes
+	// are saved as a copy of their memory, identified by a fingerprint of their reflected layout, and
+	// all other classes are saved as they would be in the versioned binary format. When a snapshot is
+	// loaded by a build where the fingerprint of a class differs, each value is found by its field
+	// path, type and size in the layouts saved with the snapshot, with enums loaded by value.
+	void SaveSnapshot(WriteBuffer& out, const void* object, const clcpp::Type* type, IPtrSave* ptr_save = 0, VBinPlanCache* plan_cache = 0);
+	void LoadSnapshot(ReadBuffer& in, void* object, const clcpp::Type* type, IPtrLoad* ptr_load = 0, VBinPlanCache* plan_cache = 0);
 
 
 	struct JSONError
@@ -159,11 +323,9 @@ namespace clutl
 			// field array. This array is typically sorted in order of name hash so that look-up by name can use
 			// a binary search.
 			//
-			// This flag will ensure fields are saved in the order that they are declared by sorting them by their
-			// byte offset first.
-			//
-			// Note that use of this flag will slow serialisation as the inner loop will have to do loop quadratically
-			// over the field array.
+			// This flag will ensure fields are saved in the order that they are declared, using the offset-sorted
+			// field array exported for each class. Fields of base classes are saved before those of the derived
+			// class. Only classes that inherit from containers fall back to a slower quadratic sort.
 			SORT_CLASS_FIELDS_BY_OFFSET = 0x80,
 		};
 	};
@@ -0,0 +1,102 @@
+
+//
+// ===============================================================================
+// clReflect
+// -------------------------------------------------------------------------------
+// Copyright (c) 2011-2012 Don Williamson & clReflect Authors (see AUTHORS file)
+// Released under MIT License (see LICENSE file)
+// ===============================================================================
+//
+// Generates a synthetic code base of a given number of classes for clReflectBench to
+// scan, merge and export. Every class has a mix of scalar, enum, pointer and C-array
+// fields along with a couple of methods, and classes are chained together in shallow
+// inheritance hierarchies within namespaces of a fixed size.
+//
+
+#include <cstdio>
+#include <cstdlib>
+
+
+namespace
+{
+	const int NB_CLASSES_PER_NAMESPACE = 64;
+	const int NB_CLASSES_PER_HIERARCHY = 8;
+	const int NB_CLASSES_PER_ENUM = 4;
+	const int NB_ENUM_CONSTANTS = 8;
+	const int ARRAY_SIZE = 8;
+
+
+	void WriteEnum(FILE* fp, int index)
+	{
+		fprintf(fp, "\t\tenum Enum%d\n\t\t{\n", index);
+		for (int i = 0; i < NB_ENUM_CONSTANTS; i++)
+			fprintf(fp, "\t\t\tEnum%d_Value%d = %d,\n", index, i, i * 3);
+		fprintf(fp, "\t\t};\n\n");
+	}
+
+
+	void WriteClass(FILE* fp, int index)
+	{
+		// Each class derives from the previous one, until the start of the next hierarchy
+		if (index % NB_CLASSES_PER_HIERARCHY == 0)
+			fprintf(fp, "\t\tstruct Class%d\n\t\t{\n", index);
+		else
+			fprintf(fp, "\t\tstruct Class%d : public Class%d\n\t\t{\n", index, index - 1);
+
+		fprintf(fp, "\t\t\tint int_field%d;\n", index);
+		fprintf(fp, "\t\t\tfloat float_field%d;\n", index);
+		fprintf(fp, "\t\t\tdouble double_field%d;\n", index);
+		fprintf(fp, "\t\t\tchar char_field%d;\n", index);
+		fprintf(fp, "\t\t\tshort short_field%d;\n", index);
+		fprintf(fp, "\t\t\tunsigned int uint_field%d;\n", index);
+		fprintf(fp, "\t\t\tEnum%d enum_field%d;\n", index / NB_CLASSES_PER_ENUM, index);
+		fprintf(fp, "\t\t\tClass%d* ptr_field%d;\n", index - index % NB_CLASSES_PER_HIERARCHY, index);
+		fprintf(fp, "\t\t\tint array_field%d[%d];\n", index, ARRAY_SIZE);
+		fprintf(fp, "\n");
+		fprintf(fp, "\t\t\tvoid Method%d(int a, float b);\n", index);
+		fprintf(fp, "\t\t\tint ConstMethod%d(const Class%d& other) const;\n", index, index);
+		fprintf(fp, "\t\t};\n\n");
+
+		fprintf(fp, "\t\tvoid Function%d(Class%d& object, int a, double b);\n\n", index, index);
+	}
+}
+
+
+int main(int argc, const char* argv[])
+{
+	if (argc < 3)
+	{
+		printf("Usage: clReflectBenchGen <output.cpp> <nb_classes>\n");
+		return 1;
+	}
+
+	FILE* fp = fopen(argv[1], "w");
+	if (fp == 0)
+	{
+		printf("Couldn't open '%s' for writing\n", argv[1]);
+		return 1;
+	}
+	int nb_classes = atoi(argv[2]);
+
+	fprintf(fp, "\n// Generated by clReflectBenchGen with %d classes\n\n", nb_classes);
+	fprintf(fp, "#include <clcpp/clcpp.h>\n\n\n");
+	fprintf(fp, "clcpp_reflect(bench)\n");
+	fprintf(fp, "namespace bench\n{\n");
+
+	for (int i = 0; i < nb_classes; i++)
+	{
+		if (i % NB_CLASSES_PER_NAMESPACE == 0)
+			fprintf(fp, "\tnamespace ns%d\n\t{\n", i / NB_CLASSES_PER_NAMESPACE);
+
+		if (i % NB_CLASSES_PER_ENUM == 0)
+			WriteEnum(fp, i / NB_CLASSES_PER_ENUM);
+		WriteClass(fp, i);
+
+		if (i % NB_CLASSES_PER_NAMESPACE == NB_CLASSES_PER_NAMESPACE - 1 || i == nb_classes - 1)
+			fprintf(fp, "\t}\n\n");
+	}
+
+	fprintf(fp, "}\n");
+	fclose(fp);
+	return 0;
+}
@@ -0,0 +1,372 @@
+
+//
+// ===============================================================================
+// clReflect
+// -------------------------------------------------------------------------------
+// Copyright (c) 2011-2012 Don Williamson & clReflect Authors (see AUTHORS file)
+// Released under MIT License (see LICENSE file)
+// ===============================================================================
+//
+// Times database loading and the most common runtime lookups against each of the
+// exported databases passed on the command-line, reporting the cost of each operation
+// and its throughput so that changes can be compared as the database grows.
+//
+
+#include <clcpp/clcpp.h>
+#include <clcpp/Containers.h>
+#include <clutl/FieldVisitor.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(CLCPP_PLATFORM_WINDOWS)
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
+
+namespace
+{
+	// Each benchmark is repeated until at least this much time has passed
+	const double MIN_BENCH_TIME = 0.25;
+
+
+	double GetSeconds()
+	{
+	#if defined(CLCPP_PLATFORM_WINDOWS)
+		LARGE_INTEGER counter, frequency;
+		QueryPerformanceCounter(&counter);
+		QueryPerformanceFrequency(&frequency);
+		return (double)counter.QuadPart / (double)frequency.QuadPart;
+	#else
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec + ts.tv_nsec * 1e-9;
+	#endif
+	}
+
+
+	class MemoryFile : public clcpp::IFile
+	{
+	public:
+		MemoryFile(const std::vector<char>& data)
+			: m_Data(data)
+			, m_Position(0)
+		{
+		}
+
+		bool Read(void* dest, clcpp::size_type size)
+		{
+			if (m_Position + size > m_Data.size())
+				return false;
+			memcpy(dest, &m_Data[m_Position], size);
+			m_Position += size;
+			return true;
+		}
+
+		bool Seek(clcpp::size_type offset)
+		{
+			if (offset > m_Data.size())
+				return false;
+			m_Position = offset;
+			return true;
+		}
+
+	private:
+		const std::vector<char>& m_Data;
+		size_t m_Position;
+	};
+
+
+	class Malloc : public clcpp::IAllocator
+	{
+		void* Alloc(clcpp::size_type size)
+		{
+			return malloc(size);
+		}
+		void Free(void* ptr)
+		{
+			free(ptr);
+		}
+	};
+
+
+	bool ReadFile(const char* filename, std::vector<char>& data)
+	{
+		FILE* fp = fopen(filename, "rb");
+		if (fp == 0)
+			return false;
+		fseek(fp, 0, SEEK_END);
+		data.resize(ftell(fp));
+		fseek(fp, 0, SEEK_SET);
+		bool read = data.empty() || fread(&data.front(), data.size(), 1, fp) == 1;
+		fclose(fp);
+		return read;
+	}
+
+
+	void GatherClasses(const clcpp::PrimitiveArray<clcpp::Class>& classes, std::vector<const clcpp::Class*>& output)
+	{
+		for (unsigned int i = 0; i < classes.size; i++)
+		{
+			output.push_back(classes[i]);
+			GatherClasses(classes[i]->classes, output);
+		}
+	}
+
+
+	void GatherClasses(const clcpp::Namespace* ns, std::vector<const clcpp::Class*>& output)
+	{
+		GatherClasses(ns->classes, output);
+		for (unsigned int i = 0; i < ns->namespaces.size; i++)
+			GatherClasses(ns->namespaces[i], output);
+	}
+
+
+	//
+	// Everything the benchmarks need from a single database, gathered up-front so that
+	// only the operation under test is timed
+	//
+	struct BenchContext
+	{
+		std::vector<char> file_data;
+		Malloc allocator;
+		clcpp::Database db;
+
+		std::vector<const clcpp::Class*> classes;
+		std::vector<const char*> type_names;
+		std::vector<unsigned int> type_hashes;
+
+		// Zero-initialised memory large enough to visit any of the classes
+		std::vector<char> object;
+
+		// Prevents the results of each operation being optimised away
+		size_t sink;
+	};
+
+
+	struct LoadBench
+	{
+		static unsigned int Run(BenchContext& ctx)
+		{
+			MemoryFile file(ctx.file_data);
+			clcpp::Database db;
+			ctx.sink += db.Load(&file, &ctx.allocator, 0);
+			return 1;
+		}
+	};
+
+
+	struct GetNameBench
+	{
+		static unsigned int Run(BenchContext& ctx)
+		{
+			for (size_t i = 0; i < ctx.type_names.size(); i++)
+				ctx.sink += ctx.db.GetName(ctx.type_names[i]).hash;
+			return ctx.type_names.size();
+		}
+	};
+
+
+	struct GetTypeBench
+	{
+		static unsigned int Run(BenchContext& ctx)
+		{
+			for (size_t i = 0; i < ctx.type_hashes.size(); i++)
+				ctx.sink += (size_t)ctx.db.GetType(ctx.type_hashes[i]);
+			return ctx.type_hashes.size();
+		}
+	};
+
+
+	struct FindPrimitiveBench
+	{
+		static unsigned int Run(BenchContext& ctx)
+		{
+			unsigned int nb_ops = 0;
+			for (size_t i = 0; i < ctx.classes.size(); i++)
+			{
+				const clcpp::PrimitiveArray<clcpp::Field>& fields = ctx.classes[i]->fields;
+				for (unsigned int j = 0; j < fields.size; j++)
+					ctx.sink += (size_t)clcpp::FindPrimitive(fields, fields[j]->name.hash);
+				nb_ops += fields.size;
+			}
+			return nb_ops;
+		}
+	};
+
+
+	struct DerivesFromBench
+	{
+		static unsigned int Run(BenchContext& ctx)
+		{
+			// Test against a spread of other classes, most of which won't be bases
+			size_t nb_classes = ctx.classes.size();
+			for (size_t i = 0; i < nb_classes; i++)
+			{
+				const clcpp::Class* other = ctx.classes[(i * 7) % nb_classes];
+				ctx.sink += ctx.classes[i]->DerivesFrom(other->name.hash);
+			}
+			return nb_classes;
+		}
+	};
+
+
+	struct IsABench
+	{
+		static unsigned int Run(BenchContext& ctx)
+		{
+			// The same pairs as DerivesFromBench, without the lookup of the type by hash
+			size_t nb_classes = ctx.classes.size();
+			for (size_t i = 0; i < nb_classes; i++)
+			{
+				const clcpp::Class* other = ctx.classes[(i * 7) % nb_classes];
+				ctx.sink += ctx.classes[i]->IsA(other);
+			}
+			return nb_classes;
+		}
+	};
+
+
+	struct ReadIteratorBench
+	{
+		static unsigned int Run(BenchContext& ctx)
+		{
+			unsigned int nb_ops = 0;
+			for (size_t i = 0; i < ctx.classes.size(); i++)
+			{
+				const clcpp::PrimitiveArray<clcpp::Field>& fields = ctx.classes[i]->fields;
+				for (unsigned int j = 0; j < fields.size; j++)
+				{
+					const clcpp::Field* field = fields[j];
+					if (field->ci == 0)
+						continue;
+
+					clcpp::ReadIterator reader(field, &ctx.object.front() + field->offset);
+					for (unsigned int k = 0; k < reader.m_Count; k++)
+					{
+						ctx.sink += (size_t)reader.GetKeyValue().value;
+						reader.MoveNext();
+					}
+					nb_ops += reader.m_Count;
+				}
+			}
+			return nb_ops;
+		}
+	};
+
+
+	struct CountingVisitor : public clutl::IFieldVisitor
+	{
+		CountingVisitor() : nb_visits(0) { }
+		void Visit(void* object, const clcpp::Field* field, const clcpp::Type* type, const clcpp::Qualifier& qualifier) const
+		{
+			nb_visits++;
+		}
+		mutable unsigned int nb_visits;
+	};
+
+
+	struct VisitFieldsBench
+	{
+		static unsigned int Run(BenchContext& ctx)
+		{
+			CountingVisitor visitor;
+			for (size_t i = 0; i < ctx.classes.size(); i++)
+				clutl::VisitFields(&ctx.object.front(), ctx.classes[i], visitor, clutl::VFT_All);
+			ctx.sink += visitor.nb_visits;
+			return visitor.nb_visits;
+		}
+	};
+
+
+	template <typename BENCH_TYPE>
+	void RunBench(BenchContext& ctx, const char* name, size_t bytes_per_op = 0)
+	{
+		// Warm up before timing enough repeats to get a stable result
+		if (BENCH_TYPE::Run(ctx) == 0)
+		{
+			printf("   %-14s    no operations in this database\n", name);
+			return;
+		}
+		double nb_ops = 0;
+		double start = GetSeconds(), elapsed;
+		do
+		{
+			nb_ops += BENCH_TYPE::Run(ctx);
+			elapsed = GetSeconds() - start;
+		} while (elapsed < MIN_BENCH_TIME);
+
+		printf("   %-14s %12.1f ns/op %14.0f ops/s", name, elapsed * 1e9 / nb_ops, nb_ops / elapsed);
+		if (bytes_per_op != 0)
+			printf(" %10.1f MB/s", bytes_per_op * nb_ops / (elapsed * 1024 * 1024));
+		printf("\n");
+	}
+
+
+	bool BenchDatabase(const char* filename)
+	{
+		BenchContext ctx;
+		ctx.sink = 0;
+		if (!ReadFile(filename, ctx.file_data))
+		{
+			printf("Couldn't read '%s'\n", filename);
+			return false;
+		}
+		MemoryFile file(ctx.file_data);
+		if (!ctx.db.Load(&file, &ctx.allocator, 0))
+		{
+			printf("Couldn't load '%s'\n", filename);
+			return false;
+		}
+
+		// Gather every class along with the names and hashes of all types
+		GatherClasses(ctx.db.GetGlobalNamespace(), ctx.classes);
+		size_t max_size = 1;
+		for (size_t i = 0; i < ctx.classes.size(); i++)
+		{
+			const clcpp::Class* cls = ctx.classes[i];
+			ctx.type_names.push_back(cls->name.text);
+			ctx.type_hashes.push_back(cls->name.hash);
+			if (cls->size > max_size)
+				max_size = cls->size;
+		}
+		ctx.object.resize(max_size, 0);
+
+		printf("%s: %u bytes, %u classes\n", filename, (unsigned int)ctx.file_data.size(), (unsigned int)ctx.classes.size());
+		RunBench<LoadBench>(ctx, "Load", ctx.file_data.size());
+		RunBench<GetNameBench>(ctx, "GetName");
+		RunBench<GetTypeBench>(ctx, "GetType");
+		RunBench<FindPrimitiveBench>(ctx, "FindPrimitive");
+		RunBench<DerivesFromBench>(ctx, "DerivesFrom");
+		RunBench<IsABench>(ctx, "IsA");
+		RunBench<ReadIteratorBench>(ctx, "ReadIterator");
+		RunBench<VisitFieldsBench>(ctx, "VisitFields");
+		printf("   checksum %x\n\n", (unsigned int)ctx.sink);
+		return true;
+	}
+}
+
+
+int main(int argc, const char* argv[])
+{
+	if (argc < 2)
+	{
+		printf("Usage: clReflectBench <database.cppbin> ...\n");
+		return 1;
+	}
+
+	// Databases are expected in order of increasing size so that results can be compared
+	int result = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!BenchDatabase(argv[i]))
+			result = 1;
+	}
+
+	return result;
+}
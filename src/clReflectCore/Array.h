@@ -5,7 +5,8 @@
 
 
 //
-// Embellish the implementation of clcpp::CArray with some RAII functionality
+// Embellish the implementation of clcpp::CArray with some RAII functionality.
+// The allocator is kept here as the runtime array may not have room for it.
 //
 template <typename TYPE>
 class CArray : public clcpp::CArray<TYPE>
@@ -13,40 +14,40 @@ class CArray : public clcpp::CArray<TYPE>
 public:
 	// Initialise an empty array
 	CArray()
+		: m_Allocator(0)
 	{
 		this->size = 0;
 		this->data = 0;
-		this->allocator = 0;
 	}
 
 	// Initialise with array count and allocator
 	CArray(unsigned int _size, clcpp::IAllocator* _allocator)
+		: m_Allocator(_allocator)
 	{		
 		this->size = _size;
-		this->allocator = _allocator;
 
 		// Allocate and call the constructor for each element
-		this->data = (TYPE*)this->allocator->Alloc(this->size * sizeof(TYPE));
+		this->data = (TYPE*)m_Allocator->Alloc(this->size * sizeof(TYPE));
 		for (unsigned int i = 0; i < this->size; i++)
 			clcpp::internal::CallConstructor(this->data + i);
 	}
 
 	// Initialise with pre-allocated data
 	CArray(TYPE* _data, unsigned int _size)
+		: m_Allocator(0)
 	{
 		this->size = _size;
 		this->data = _data;
-		this->allocator = 0;
 	}
 
 	~CArray()
 	{
-		if (this->allocator)
+		if (m_Allocator)
 		{
 			// Call the destructor on each element and free the allocated memory
 			for (unsigned int i = 0; i < this->size; i++)
 				clcpp::internal::CallDestructor(this->data + i);
-			this->allocator->Free(this->data);
+			m_Allocator->Free(this->data);
 		}
 	}
 
@@ -60,6 +61,9 @@ public:
 		clcpp::internal::Assert(index < this->size);
 		return this->data[index];
 	}
+
+private:
+	clcpp::IAllocator* m_Allocator;
 };
 
 
@@ -85,7 +89,6 @@ inline void shallow_copy(clcpp::CArray<TYPE>& dest, const clcpp::CArray<TYPE>& s
 {
 	dest.size = src.size;
 	dest.data = src.data;
-	dest.allocator = src.allocator;
 }
 
 
@@ -62,6 +62,14 @@ public:
 		m_Position += m_ElementSize;
 	}
 
+	bool GetContiguous(const void*& data, unsigned int& count) const
+	{
+		clcpp::internal::Assert(m_Position <= m_Size);
+		data = m_ArrayData + m_Position;
+		count = (unsigned int)((m_Size - m_Position) / m_ElementSize);
+		return true;
+	}
+
 private:
 	// Construction values
 	const char* m_ArrayData;
@@ -123,6 +131,14 @@ public:
 		return AddEmpty();
 	}
 
+	void* AddEmptyContiguous(unsigned int count)
+	{
+		clcpp::internal::Assert(m_Position + count * m_ElementSize <= m_Size);
+		void* value_ptr = m_ArrayData + m_Position;
+		m_Position += count * m_ElementSize;
+		return value_ptr;
+	}
+
 private:
 	// Construction values
 	char* m_ArrayData;
@@ -189,6 +189,29 @@ namespace
 	}
 
 
+	template <typename ARRAY_TYPE, typename COMPARE_L_TYPE, unsigned int (GET_HASH_FUNC)(COMPARE_L_TYPE)>
+	int HashTableSearch(const clcpp::internal::HashTable& table, const clcpp::CArray<ARRAY_TYPE>& entries, unsigned int compare_hash)
+	{
+		// Fall back to a binary search if no table could be built for the entries
+		int index = table.Find(compare_hash);
+		if (index == -1)
+			return BinarySearch<ARRAY_TYPE, COMPARE_L_TYPE, GET_HASH_FUNC>(entries, compare_hash);
+
+		// Hashes that aren't in the table still map to an entry so verify the match
+		if (GET_HASH_FUNC(entries.data[index]) != compare_hash)
+			return -1;
+
+		return index;
+	}
+
+
+	struct PtrLink
+	{
+		clcpp::size_type ptr_offset;
+		clcpp::size_type target_offset;
+	};
+
+
 	template <typename TYPE> bool ReadArray(clcpp::IFile* file, clcpp::CArray<TYPE>& array, unsigned int size, clcpp::IAllocator* allocator)
 	{
 		// Allocate space for the data
@@ -199,6 +222,7 @@ namespace
 		if (!file->Read((void*)array.data, array.size * sizeof(TYPE)))
 		{
 			allocator->Free(array.data);
+			array.data = 0;
 			return false;
 		}
 
@@ -206,76 +230,298 @@ namespace
 	}
 
 
-	clcpp::internal::DatabaseMem* LoadMemoryMappedDatabase(clcpp::IFile* file, clcpp::IAllocator* allocator)
+	bool VerifyFileHeader(const clcpp::internal::DatabaseFileHeader& file_header)
 	{
-		// Read the header and verify the version and signature
-		clcpp::internal::DatabaseFileHeader file_header, cmp_header;
-		if (!file->Read(&file_header, sizeof(file_header)))
-			return 0;
+		// Verify the version and signature against that of the runtime
+		clcpp::internal::DatabaseFileHeader cmp_header;
 		if (file_header.version != cmp_header.version)
-			return 0;
+			return false;
 		if (file_header.signature0 != cmp_header.signature0 || file_header.signature1 != cmp_header.signature1)
-			return 0;
+			return false;
 
-		// Read the memory mapped data
-		char* base_data = (char*)allocator->Alloc(file_header.data_size);
-		clcpp::internal::DatabaseMem* database_mem = (clcpp::internal::DatabaseMem*)base_data;
-		if (!file->Read(base_data, file_header.data_size))
-			return 0;
+		// The layout of the memory map has to match that of the runtime
+	#if defined(CLCPP_COMPACT_LAYOUT)
+		if ((file_header.flags & clcpp::internal::DATABASE_FLAG_COMPACT_LAYOUT) == 0)
+			return false;
+	#else
+		if (file_header.flags & clcpp::internal::DATABASE_FLAG_COMPACT_LAYOUT)
+			return false;
+	#endif
 
-		// Read the schema descriptions
-		clcpp::CArray<PtrSchema> schemas;
-		if (!ReadArray(file, schemas, file_header.nb_ptr_schemas, allocator))
-			return 0;
+		return true;
+	}
 
-		// Read the pointer offsets for all the schemas
-		clcpp::CArray<clcpp::size_type> ptr_offsets;
-		if (!ReadArray(file, ptr_offsets, file_header.nb_ptr_offsets, allocator))
-			return 0;
 
-		// Read the pointer relocation instructions
-		clcpp::CArray<PtrRelocation> relocations;
-		if (!ReadArray(file, relocations, file_header.nb_ptr_relocations, allocator))
+	bool DecompressBlock(const char* src, unsigned int src_size, char* dest, unsigned int dest_size)
+	{
+		const unsigned char* in = (const unsigned char*)src;
+		const unsigned char* in_end = in + src_size;
+		unsigned char* out = (unsigned char*)dest;
+		unsigned char* out_end = out + dest_size;
+
+		while (in < in_end)
+		{
+			// The token packs the literal count and match length into nibbles, with any
+			// lengths that don't fit continued by bytes of 255 until the remainder
+			unsigned int token = *in++;
+			unsigned int length = token >> 4;
+			if (length == 15)
+			{
+				unsigned int extra;
+				do
+				{
+					if (in == in_end)
+						return false;
+					extra = *in++;
+					length += extra;
+				} while (extra == 255);
+			}
+
+			// Copy the literals
+			if (length > (unsigned int)(in_end - in) || length > (unsigned int)(out_end - out))
+				return false;
+			for (const unsigned char* end = in + length; in != end; )
+				*out++ = *in++;
+
+			// The last sequence in a block has no match
+			if (in == in_end)
+				break;
+
+			// Read the match offset and length, which includes the minimum of 4 bytes
+			if (in_end - in < 2)
+				return false;
+			unsigned int offset = in[0] | (in[1] << 8);
+			in += 2;
+			if (offset == 0 || offset > (unsigned int)(out - (unsigned char*)dest))
+				return false;
+			length = token & 15;
+			if (length == 15)
+			{
+				unsigned int extra;
+				do
+				{
+					if (in == in_end)
+						return false;
+					extra = *in++;
+					length += extra;
+				} while (extra == 255);
+			}
+			length += 4;
+
+			// Copy the match one byte at a time as it can overlap the output
+			if (length > (unsigned int)(out_end - out))
+				return false;
+			const unsigned char* match = out - offset;
+			for (const unsigned char* end = out + length; out != end; )
+				*out++ = *match++;
+		}
+
+		return out == out_end;
+	}
+
+
+	//
+	// Reads a sequence of compressed blocks from a file, decompressing each block straight
+	// into the destination when it's entirely covered by the read
+	//
+	class BlockReader : public clcpp::IFile
+	{
+	public:
+		BlockReader(clcpp::IFile* file, clcpp::IAllocator* allocator)
+			: m_File(file)
+			, m_Allocator(allocator)
+			, m_CompressedData(0)
+			, m_BlockData(0)
+			, m_BlockSize(0)
+			, m_BlockPosition(0)
+		{
+		}
+
+		~BlockReader()
+		{
+			if (m_CompressedData != 0)
+				m_Allocator->Free(m_CompressedData);
+			if (m_BlockData != 0)
+				m_Allocator->Free(m_BlockData);
+		}
+
+		bool Read(void* dest, clcpp::size_type size)
+		{
+			char* dest_data = (char*)dest;
+			while (size != 0)
+			{
+				// Copy anything left over from the last block that was only partially read
+				if (m_BlockPosition < m_BlockSize)
+				{
+					clcpp::size_type copy_size = m_BlockSize - m_BlockPosition;
+					if (copy_size > size)
+						copy_size = size;
+					for (clcpp::size_type i = 0; i < copy_size; i++)
+						dest_data[i] = m_BlockData[m_BlockPosition + i];
+					m_BlockPosition += copy_size;
+					dest_data += copy_size;
+					size -= copy_size;
+					continue;
+				}
+
+				clcpp::internal::DatabaseBlockHeader header;
+				if (!m_File->Read(&header, sizeof(header)))
+					return false;
+				if (header.data_size == 0 || header.data_size > clcpp::internal::DATABASE_BLOCK_SIZE || header.compressed_size > header.data_size)
+					return false;
+
+				// Blocks that aren't read entirely are buffered for subsequent reads
+				if (header.data_size > size)
+				{
+					if (m_BlockData == 0)
+						m_BlockData = (char*)m_Allocator->Alloc(clcpp::internal::DATABASE_BLOCK_SIZE);
+					if (!ReadBlock(header, m_BlockData))
+						return false;
+					m_BlockSize = header.data_size;
+					m_BlockPosition = 0;
+					continue;
+				}
+
+				if (!ReadBlock(header, dest_data))
+					return false;
+				dest_data += header.data_size;
+				size -= header.data_size;
+			}
+
+			return true;
+		}
+
+	private:
+		bool ReadBlock(const clcpp::internal::DatabaseBlockHeader& header, char* dest)
+		{
+			// Uncompressed blocks are read directly
+			if (header.compressed_size == header.data_size)
+				return m_File->Read(dest, header.data_size);
+
+			if (m_CompressedData == 0)
+				m_CompressedData = (char*)m_Allocator->Alloc(clcpp::internal::DATABASE_BLOCK_SIZE);
+			return m_File->Read(m_CompressedData, header.compressed_size) &&
+				DecompressBlock(m_CompressedData, header.compressed_size, dest, header.data_size);
+		}
+
+		clcpp::IFile* m_File;
+		clcpp::IAllocator* m_Allocator;
+		char* m_CompressedData;
+		char* m_BlockData;
+		clcpp::size_type m_BlockSize;
+		clcpp::size_type m_BlockPosition;
+	};
+}
+
+
+//
+// Loaded sections of the memory map, with the relocation data required to load the
+// remaining sections on demand
+//
+struct clcpp::internal::DatabaseSections
+{
+	DatabaseFileHeader header;
+
+	// Everything needed to load and initialise a deferred section
+	IFile* file;
+	IAllocator* allocator;
+	Database* database;
+	pointer_type base_address;
+	unsigned int options;
+
+	// Relocation data, released once all sections have been loaded
+	CArray<PtrSchema> schemas;
+	CArray<size_type> ptr_offsets;
+	CArray<PtrRelocation> relocations;
+	CArray<PtrLink> links;
+
+	// Separate allocation for each section so that deferred sections use no memory
+	char* data[NB_DATABASE_SECTIONS];
+	unsigned int loaded_sections;
+};
+
+
+namespace
+{
+	int GetSectionIndex(const clcpp::internal::DatabaseFileHeader& file_header, clcpp::size_type offset)
+	{
+		for (int i = 0; i < clcpp::internal::NB_DATABASE_SECTIONS; i++)
+		{
+			const clcpp::internal::DatabaseSection& section = file_header.sections[i];
+			if (offset < section.data_offset + section.data_size)
+				return i;
+		}
+
+		// Pointers to empty arrays can point at the end of the memory map
+		if (offset == file_header.data_size)
+			return clcpp::internal::NB_DATABASE_SECTIONS - 1;
+		return -1;
+	}
+
+
+	char* GetSectionAddress(const clcpp::internal::DatabaseSections& sections, clcpp::size_type offset)
+	{
+		// Locate the section and ensure the offset is within range of the memory map
+		int index = GetSectionIndex(sections.header, offset);
+		clcpp::internal::Assert(index != -1);
+
+		// Pointers to sections that haven't been loaded yet are left null
+		if ((sections.loaded_sections & (1 << index)) == 0)
 			return 0;
+		return sections.data[index] + (offset - sections.header.sections[index].data_offset);
+	}
+
 
-		// Iterate over every relocation instruction
-		for (int i = 0; i < file_header.nb_ptr_relocations; i++)
+	void RelocateSection(clcpp::internal::DatabaseSections& sections, int index)
+	{
+		const clcpp::internal::DatabaseSection& section = sections.header.sections[index];
+		char* section_data = sections.data[index];
+
+		// Iterate over every relocation instruction that targets this section
+		for (int i = 0; i < section.nb_ptr_relocations; i++)
 		{
-			PtrRelocation& reloc = (PtrRelocation&)relocations[i];
-			PtrSchema& schema = (PtrSchema&)schemas[reloc.schema_handle];
+			const PtrRelocation& reloc = sections.relocations[section.first_ptr_relocation + i];
+			const PtrSchema& schema = sections.schemas[reloc.schema_handle];
 
 			// Take a weak C-array pointer to the schema's pointer offsets (for bounds checking)
 			clcpp::CArray<clcpp::size_type> schema_ptr_offsets;
-			schema_ptr_offsets.data = (clcpp::size_type*)&ptr_offsets[schema.ptrs_offset];
+			schema_ptr_offsets.data = (clcpp::size_type*)&sections.ptr_offsets[schema.ptrs_offset];
 			schema_ptr_offsets.size = schema.nb_ptrs;
 
 			// Iterate over all objects in the instruction
 			for (int j = 0; j < reloc.nb_objects; j++)
 			{
-	            clcpp::size_type object_offset = reloc.offset + j * schema.stride;
+				clcpp::size_type object_offset = reloc.offset - section.data_offset + j * schema.stride;
 
 				// All pointers in the schema
 				for (clcpp::size_type k = 0; k < schema.nb_ptrs; k++)
 				{
-	                clcpp::size_type ptr_offset = object_offset + schema_ptr_offsets[k];
-	                clcpp::size_type& ptr = (clcpp::size_type&)*(base_data + ptr_offset);
-
-					// Ensure the pointer relocation is within range of the memory map before patching
-					clcpp::internal::Assert(ptr <= file_header.data_size);
+					clcpp::size_type ptr_offset = object_offset + schema_ptr_offsets[k];
+					clcpp::internal::Assert(ptr_offset < section.data_size);
+					clcpp::size_type& ptr = (clcpp::size_type&)*(section_data + ptr_offset);
 
 					// Only patch non-null
 					if (ptr != 0)
-						ptr += (clcpp::size_type)base_data;
+					{
+						// Pointers are stored relative to the base the file was prelinked against
+						ptr -= (clcpp::size_type)sections.header.data_base;
+						ptr = (clcpp::size_type)GetSectionAddress(sections, ptr);
+					}
 				}
 			}
 		}
 
-		// Release temporary array memory
-		allocator->Free(relocations.data);
-		allocator->Free(ptr_offsets.data);
-		allocator->Free(schemas.data);
-
-		return database_mem;
+		// Patch pointers in sections that were loaded earlier and point into this one
+		for (unsigned int i = 0; i < sections.links.size; i++)
+		{
+			const PtrLink& link = sections.links[i];
+			if (GetSectionIndex(sections.header, link.target_offset) == index)
+			{
+				clcpp::size_type* ptr = (clcpp::size_type*)GetSectionAddress(sections, link.ptr_offset);
+				if (ptr != 0)
+					*ptr = (clcpp::size_type)GetSectionAddress(sections, link.target_offset);
+			}
+		}
 	}
 
 
@@ -291,14 +537,271 @@ namespace
 	}
 
 
+#if !defined(CLCPP_COMPACT_LAYOUT)
 	template <typename TYPE>
 	void ParentPrimitivesToDatabase(clcpp::CArray<TYPE>& primitives, clcpp::Database* database)
 	{
 		for (unsigned int i = 0; i < primitives.size; i++)
 			((clcpp::Primitive&)primitives[i]).database = database;
 	}
+#endif
+
+
+	void InitialiseSection(clcpp::internal::DatabaseSections& sections, int index)
+	{
+		clcpp::internal::DatabaseMem& dbmem = *(clcpp::internal::DatabaseMem*)sections.data[clcpp::internal::DATABASE_SECTION_TYPES];
+
+		// Rebasing functions is required mainly for DLLs and executables that run under Windows 7
+		// using its Address Space Layout Randomisation security feature.
+		if (index == clcpp::internal::DATABASE_SECTION_FUNCTIONS && (sections.options & clcpp::Database::OPT_DONT_REBASE_FUNCTIONS) == 0)
+			RebaseFunctions(dbmem, sections.base_address);
+
+	// Primitives don't point back to their database in the compact layout
+	#if !defined(CLCPP_COMPACT_LAYOUT)
+
+		clcpp::Database* database = sections.database;
+
+		// Tell each loaded primitive that they belong to this database
+		switch (index)
+		{
+		case (clcpp::internal::DATABASE_SECTION_TYPES):
+			ParentPrimitivesToDatabase(dbmem.types, database);
+			ParentPrimitivesToDatabase(dbmem.enum_constants, database);
+			ParentPrimitivesToDatabase(dbmem.enums, database);
+			ParentPrimitivesToDatabase(dbmem.fields, database);
+			ParentPrimitivesToDatabase(dbmem.classes, database);
+			ParentPrimitivesToDatabase(dbmem.templates, database);
+			ParentPrimitivesToDatabase(dbmem.template_types, database);
+			ParentPrimitivesToDatabase(dbmem.namespaces, database);
+			break;
+
+		case (clcpp::internal::DATABASE_SECTION_FUNCTIONS):
+			ParentPrimitivesToDatabase(dbmem.functions, database);
+			break;
+
+		case (clcpp::internal::DATABASE_SECTION_ATTRIBUTES):
+			ParentPrimitivesToDatabase(dbmem.flag_attributes, database);
+			ParentPrimitivesToDatabase(dbmem.int_attributes, database);
+			ParentPrimitivesToDatabase(dbmem.float_attributes, database);
+			ParentPrimitivesToDatabase(dbmem.primitive_attributes, database);
+			ParentPrimitivesToDatabase(dbmem.text_attributes, database);
+			break;
+		}
+
+	#endif
+	}
+
+
+	bool ReadSection(clcpp::internal::DatabaseSections& sections, int index)
+	{
+		// Read the section data
+		const clcpp::internal::DatabaseSection& section = sections.header.sections[index];
+		sections.data[index] = (char*)sections.allocator->Alloc(section.data_size);
+		bool read = false;
+		if (sections.header.flags & clcpp::internal::DATABASE_FLAG_COMPRESSED)
+		{
+			BlockReader reader(sections.file, sections.allocator);
+			read = reader.Read(sections.data[index], section.data_size);
+		}
+		else
+		{
+			read = sections.file->Read(sections.data[index], section.data_size);
+		}
+		if (!read)
+		{
+			sections.allocator->Free(sections.data[index]);
+			sections.data[index] = 0;
+			return false;
+		}
+
+		// Mark as loaded before relocating so that pointers within the section can be patched
+		sections.loaded_sections |= 1 << index;
+		RelocateSection(sections, index);
+		InitialiseSection(sections, index);
+		return true;
+	}
+
+
+	void ReleaseRelocationData(clcpp::internal::DatabaseSections& sections)
+	{
+		clcpp::IAllocator* allocator = sections.allocator;
+		if (sections.links.data != 0)
+			allocator->Free(sections.links.data);
+		if (sections.relocations.data != 0)
+			allocator->Free(sections.relocations.data);
+		if (sections.ptr_offsets.data != 0)
+			allocator->Free(sections.ptr_offsets.data);
+		if (sections.schemas.data != 0)
+			allocator->Free(sections.schemas.data);
+		sections.links.data = 0;
+		sections.relocations.data = 0;
+		sections.ptr_offsets.data = 0;
+		sections.schemas.data = 0;
+
+		// The file is no longer needed
+		sections.file = 0;
+	}
 
 
+	void FreeDatabaseSections(clcpp::internal::DatabaseSections* sections)
+	{
+		clcpp::IAllocator* allocator = sections->allocator;
+		ReleaseRelocationData(*sections);
+		for (int i = 0; i < clcpp::internal::NB_DATABASE_SECTIONS; i++)
+		{
+			if (sections->data[i] != 0)
+				allocator->Free(sections->data[i]);
+		}
+		allocator->Free(sections);
+	}
+
+
+	unsigned int GetLinkedSections(const clcpp::internal::DatabaseSections& sections, unsigned int from_sections)
+	{
+		// The database object's own arrays are skipped as they're only reached through the
+		// database, which loads their sections on first access
+		const clcpp::internal::DatabaseSection& types = sections.header.sections[clcpp::internal::DATABASE_SECTION_TYPES];
+		clcpp::size_type dbmem_end = types.data_offset + sizeof(clcpp::internal::DatabaseMem);
+
+		// Gather the sections pointed to from within the given sections
+		unsigned int linked = 0;
+		for (unsigned int i = 0; i < sections.links.size; i++)
+		{
+			const PtrLink& link = sections.links[i];
+			if (link.ptr_offset >= types.data_offset && link.ptr_offset < dbmem_end)
+				continue;
+			int from = GetSectionIndex(sections.header, link.ptr_offset);
+			int to = GetSectionIndex(sections.header, link.target_offset);
+			if (from != -1 && to != -1 && (from_sections & (1 << from)))
+				linked |= 1 << to;
+		}
+
+		// Name text can stay deferred as names are looked up through the database
+		return linked & ~clcpp::Database::SECTION_NAMES;
+	}
+
+
+	bool LoadSection(clcpp::internal::DatabaseSections& sections, int index)
+	{
+		if (sections.loaded_sections & (1 << index))
+			return true;
+
+		// Seek to the section, which is only possible while the file is still around
+		if (sections.file == 0)
+			return false;
+		const clcpp::internal::DatabaseSection& section = sections.header.sections[index];
+		if (!sections.file->Seek(section.file_offset))
+			return false;
+		if (!ReadSection(sections, index))
+			return false;
+
+		// Load any sections this one points into so that no pointers are left dangling
+		unsigned int linked = GetLinkedSections(sections, 1 << index);
+		for (int i = 0; i < clcpp::internal::NB_DATABASE_SECTIONS; i++)
+		{
+			if ((linked & (1 << i)) && !LoadSection(sections, i))
+				return false;
+		}
+
+		// Nothing more to load if this was the last section
+		if (sections.loaded_sections == clcpp::Database::SECTION_ALL)
+			ReleaseRelocationData(sections);
+
+		return true;
+	}
+
+
+	bool EnsureSectionLoaded(clcpp::internal::DatabaseSections* sections, int index)
+	{
+		// Databases loaded in-place don't have any sections to load
+		return sections == 0 || (sections->loaded_sections & (1 << index)) != 0 || LoadSection(*sections, index);
+	}
+
+
+	clcpp::internal::DatabaseSections* LoadDatabaseSections(clcpp::IFile* file, clcpp::IAllocator* allocator, clcpp::Database* database, clcpp::pointer_type base_address, unsigned int options, unsigned int load_sections)
+	{
+		// Read the header and verify the version and signature
+		clcpp::internal::DatabaseFileHeader file_header;
+		if (!file->Read(&file_header, sizeof(file_header)))
+			return 0;
+		if (!VerifyFileHeader(file_header))
+			return 0;
+
+		// Create an empty set of sections
+		clcpp::internal::DatabaseSections* sections = (clcpp::internal::DatabaseSections*)allocator->Alloc(sizeof(clcpp::internal::DatabaseSections));
+		char* sections_data = (char*)sections;
+		for (unsigned int i = 0; i < sizeof(clcpp::internal::DatabaseSections); i++)
+			sections_data[i] = 0;
+		sections->header = file_header;
+		sections->file = file;
+		sections->allocator = allocator;
+		sections->database = database;
+		sections->base_address = base_address;
+		sections->options = options;
+
+		// Read the schema descriptions, the pointer offsets for all the schemas, the
+		// pointer relocation instructions and the links between sections. In compressed
+		// files these are stored as a single sequence of blocks.
+		bool compressed = (file_header.flags & clcpp::internal::DATABASE_FLAG_COMPRESSED) != 0;
+		BlockReader reader(file, allocator);
+		clcpp::IFile* table_file = compressed ? (clcpp::IFile*)&reader : file;
+		if (!ReadArray(table_file, sections->schemas, file_header.nb_ptr_schemas, allocator) ||
+			!ReadArray(table_file, sections->ptr_offsets, file_header.nb_ptr_offsets, allocator) ||
+			!ReadArray(table_file, sections->relocations, file_header.nb_ptr_relocations, allocator) ||
+			!ReadArray(table_file, sections->links, file_header.nb_ptr_links, allocator))
+		{
+			FreeDatabaseSections(sections);
+			return 0;
+		}
+
+		// Skip any padding before the memory map
+		clcpp::size_type position = file_header.sections[0].file_offset;
+		if (!compressed)
+		{
+			position = sizeof(file_header) +
+				file_header.nb_ptr_schemas * sizeof(PtrSchema) +
+				file_header.nb_ptr_offsets * sizeof(clcpp::size_type) +
+				file_header.nb_ptr_relocations * sizeof(PtrRelocation) +
+				file_header.nb_ptr_links * sizeof(PtrLink);
+		}
+		for (char padding; position < file_header.sections[0].file_offset; position++)
+		{
+			if (!file->Read(&padding, 1))
+			{
+				FreeDatabaseSections(sections);
+				return 0;
+			}
+		}
+
+		// Sections can only be deferred if they can be skipped now and seeked back to later
+		bool can_defer = (load_sections & clcpp::Database::SECTION_ALL) != clcpp::Database::SECTION_ALL && file->Seek(position);
+
+		// Read all required sections in file order, always including the types as they contain
+		// the database object itself, along with any sections they point into
+		load_sections |= clcpp::Database::SECTION_TYPES;
+		unsigned int linked;
+		while ((linked = GetLinkedSections(*sections, load_sections) & ~load_sections) != 0)
+			load_sections |= linked;
+		for (int i = 0; i < clcpp::internal::NB_DATABASE_SECTIONS; i++)
+		{
+			if (can_defer && (load_sections & (1 << i)) == 0)
+				continue;
+
+			const clcpp::internal::DatabaseSection& section = file_header.sections[i];
+			if ((section.file_offset != position && !file->Seek(section.file_offset)) || !ReadSection(*sections, i))
+			{
+				FreeDatabaseSections(sections);
+				return 0;
+			}
+			position = section.file_offset + section.file_size;
+		}
+
+		// Keep hold of the relocation data and file only while there are sections left to load
+		if (sections->loaded_sections == clcpp::Database::SECTION_ALL)
+			ReleaseRelocationData(*sections);
+
+		return sections;
+	}
 	clcpp::pointer_type GetLoadAddress()
 	{
 	#if defined(CLCPP_PLATFORM_WINDOWS)
@@ -383,6 +886,38 @@ clcpp::Range clcpp::internal::FindOverloadedPrimitive(const CArray<const Primiti
 }
 
 
+int clcpp::internal::FindHashIndex(const unsigned int* hashes, unsigned int nb_hashes, unsigned int hash)
+{
+	// Most child arrays are small enough that a linear scan over the hashes beats a
+	// search with unpredictable branches
+	if (nb_hashes <= 16)
+	{
+		for (unsigned int i = 0; i < nb_hashes; i++)
+		{
+			if (hashes[i] >= hash)
+				return hashes[i] == hash ? (int)i : -1;
+		}
+		return -1;
+	}
+
+	// Branch-free lower bound search where the comparison resolves to a conditional move
+	const unsigned int* base = hashes;
+	unsigned int n = nb_hashes;
+	while (n > 1)
+	{
+		unsigned int half = n / 2;
+		base = base[half] < hash ? base + half : base;
+		n -= half;
+	}
+	base += *base < hash;
+
+	unsigned int index = (unsigned int)(base - hashes);
+	if (index < nb_hashes && *base == hash)
+		return index;
+	return -1;
+}
+
+
 clcpp::Name::Name()
 	: hash(0)
 	, text(0)
@@ -415,11 +950,14 @@ clcpp::ContainerInfo::ContainerInfo()
 clcpp::Primitive::Primitive(Kind k)
 	: kind(k)
 	, parent(0)
+#if !defined(CLCPP_COMPACT_LAYOUT)
 	, database(0)
+#endif
 {
 }
 
 
+
 clcpp::Attribute::Attribute()
 	: Primitive(KIND)
 {
@@ -464,6 +1002,9 @@ clcpp::Type::Type()
 	: Primitive(KIND)
 	, size(0)
 	, ci(0)
+	, dfs_first(0)
+	, dfs_last(0)
+	, secondary_base_index(0)
 {
 }
 
@@ -472,12 +1013,25 @@ clcpp::Type::Type(Kind k)
 	: Primitive(k)
 	, size(0)
 	, ci(0)
+	, dfs_first(0)
+	, dfs_last(0)
+	, secondary_base_index(0)
 {
 }
 
 
 bool clcpp::Type::DerivesFrom(unsigned int type_name_hash) const
 {
+#if !defined(CLCPP_COMPACT_LAYOUT)
+	// Use the constant-time check if the type can be found in this type's database
+	if (database != 0)
+	{
+		const Type* type = database->GetType(type_name_hash);
+		if (type != 0)
+			return type != this && IsA(type);
+	}
+#endif
+
 	// Search in immediate bases
 	for (unsigned int i = 0; i < base_types.size; i++)
 	{
@@ -526,11 +1080,38 @@ clcpp::EnumConstant::EnumConstant()
 
 clcpp::Enum::Enum()
 	: Type(KIND)
+	, value_table_base(0)
 	, flag_attributes(0)
 {
 }
 
 
+const clcpp::EnumConstant* clcpp::Enum::FindConstantByValue(int value) const
+{
+	// Direct lookup for enums with a compact range of values
+	if (value_table.size != 0)
+	{
+		unsigned int index = (unsigned int)value - (unsigned int)value_table_base;
+		return index < value_table.size ? value_table.data[index] : 0;
+	}
+
+	// Binary search for the first constant with the value
+	unsigned int first = 0;
+	unsigned int last = constants_by_value.size;
+	while (first < last)
+	{
+		unsigned int mid = (first + last) >> 1;
+		if (constants_by_value.data[mid]->value < value)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+	if (first < constants_by_value.size && constants_by_value.data[first]->value == value)
+		return constants_by_value.data[first];
+	return 0;
+}
+
+
 clcpp::Field::Field()
 	: Primitive(KIND)
 	, type(0)
@@ -592,14 +1173,16 @@ clcpp::Namespace::Namespace()
 clcpp::Database::Database()
 	: m_DatabaseMem(0)
 	, m_Allocator(0)
+	, m_Sections(0)
 {
 }
 
 
 clcpp::Database::~Database()
 {
-	if (m_DatabaseMem)
-		m_Allocator->Free(m_DatabaseMem);
+	// Databases loaded in-place don't own their memory
+	if (m_Sections)
+		FreeDatabaseSections(m_Sections);
 }
 
 
@@ -611,44 +1194,112 @@ bool clcpp::Database::Load(IFile* file, IAllocator* allocator, unsigned int opti
 
 
 bool clcpp::Database::Load(IFile* file, IAllocator* allocator, pointer_type base_address, unsigned int options)
+{
+	return Load(file, allocator, base_address, options, SECTION_ALL);
+}
+
+
+bool clcpp::Database::Load(IFile* file, IAllocator* allocator, pointer_type base_address, unsigned int options, unsigned int sections)
 {
 	// Load the database
 	internal::Assert(m_DatabaseMem == 0 && "Database already loaded");
 	m_Allocator = allocator;
-	m_DatabaseMem = LoadMemoryMappedDatabase(file, m_Allocator);
+	m_Sections = LoadDatabaseSections(file, m_Allocator, this, base_address, options, sections);
 
-	if (m_DatabaseMem != 0)
-	{
-		// Rebasing functions is required mainly for DLLs and executables that run under Windows 7
-		// using its Address Space Layout Randomisation security feature.
-		if ((options & OPT_DONT_REBASE_FUNCTIONS) == 0)
-			RebaseFunctions(*m_DatabaseMem, base_address);
+	// The database object is at the start of the types section
+	if (m_Sections != 0)
+		m_DatabaseMem = (internal::DatabaseMem*)m_Sections->data[internal::DATABASE_SECTION_TYPES];
 
-		// Tell each loaded primitive that they belong to this database
-		ParentPrimitivesToDatabase(m_DatabaseMem->types, this);
-		ParentPrimitivesToDatabase(m_DatabaseMem->enum_constants, this);
-		ParentPrimitivesToDatabase(m_DatabaseMem->enums, this);
-		ParentPrimitivesToDatabase(m_DatabaseMem->fields, this);
-		ParentPrimitivesToDatabase(m_DatabaseMem->functions, this);
-		ParentPrimitivesToDatabase(m_DatabaseMem->classes, this);
-		ParentPrimitivesToDatabase(m_DatabaseMem->templates, this);
-		ParentPrimitivesToDatabase(m_DatabaseMem->template_types, this);
-		ParentPrimitivesToDatabase(m_DatabaseMem->namespaces, this);
-		ParentPrimitivesToDatabase(m_DatabaseMem->flag_attributes, this);
-		ParentPrimitivesToDatabase(m_DatabaseMem->int_attributes, this);
-		ParentPrimitivesToDatabase(m_DatabaseMem->float_attributes, this);
-		ParentPrimitivesToDatabase(m_DatabaseMem->primitive_attributes, this);
-		ParentPrimitivesToDatabase(m_DatabaseMem->text_attributes, this);
+	return m_DatabaseMem != 0;
+}
+
+
+clcpp::pointer_type clcpp::Database::GetModuleLoadAddress()
+{
+	return GetLoadAddress();
+}
+
+
+bool clcpp::Database::LoadSections(unsigned int sections) const
+{
+	if (m_DatabaseMem == 0)
+		return false;
+
+	for (int i = 0; i < internal::NB_DATABASE_SECTIONS; i++)
+	{
+		if ((sections & (1 << i)) && !EnsureSectionLoaded(m_Sections, i))
+			return false;
 	}
 
-	return m_DatabaseMem != 0;
+	return true;
+}
+
+
+unsigned int clcpp::Database::GetLoadedSections() const
+{
+	if (m_Sections != 0)
+		return m_Sections->loaded_sections;
+	return m_DatabaseMem != 0 ? SECTION_ALL : 0;
+}
+
+
+bool clcpp::Database::LoadInPlace(const void* file_data, size_type file_size, unsigned int options)
+{
+	internal::Assert(m_DatabaseMem == 0 && "Database already loaded");
+
+	// Verify the header and ensure the memory map is entirely contained within the file data
+	if (file_size < sizeof(internal::DatabaseFileHeader))
+		return false;
+	const internal::DatabaseFileHeader& file_header = *(const internal::DatabaseFileHeader*)file_data;
+	if (!VerifyFileHeader(file_header))
+		return false;
+	if (file_header.flags & internal::DATABASE_FLAG_COMPRESSED)
+		return false;
+	if (file_header.data_offset > file_size || file_header.data_size > file_size - file_header.data_offset)
+		return false;
+
+	// Without relocation, the pointers in the memory map are only valid if the file was
+	// prelinked against the address of the memory map within the file
+	pointer_type data_base = (pointer_type)file_data + file_header.data_offset;
+	if (file_header.data_base == 0 || file_header.data_base != data_base)
+		return false;
+
+	// The file data is treated as read-only so function addresses can't be rebased. Fail
+	// instead of leaving function addresses that point to the wrong place.
+	internal::DatabaseMem* database_mem = (internal::DatabaseMem*)data_base;
+	if ((options & OPT_DONT_REBASE_FUNCTIONS) == 0 &&
+		database_mem->function_base_address != 0 &&
+		database_mem->function_base_address != GetLoadAddress())
+		return false;
+
+	// Primitives are not parented to this database as that would require writing to them
+	m_DatabaseMem = database_mem;
+	m_Allocator = 0;
+	return true;
+}
+
+
+clcpp::pointer_type clcpp::Database::GetInPlaceLoadAddress(IFile* file)
+{
+	// Read the header and verify the version and signature
+	internal::DatabaseFileHeader file_header;
+	if (!file->Read(&file_header, sizeof(file_header)))
+		return 0;
+	if (!VerifyFileHeader(file_header) || file_header.data_base == 0)
+		return 0;
+
+	// The memory map has to be at its prelinked address
+	return file_header.data_base - file_header.data_offset;
 }
 
 
 clcpp::Name clcpp::Database::GetName(unsigned int hash) const
 {
+	if (!EnsureSectionLoaded(m_Sections, internal::DATABASE_SECTION_NAMES))
+		return clcpp::Name();
+
 	// Lookup the name by hash
-	int index = BinarySearch<Name, Name, GetNameHash>(m_DatabaseMem->names, hash);
+	int index = HashTableSearch<Name, Name, GetNameHash>(m_DatabaseMem->name_table, m_DatabaseMem->names, hash);
 	if (index == -1)
 		return clcpp::Name();
 	return m_DatabaseMem->names[index];
@@ -672,13 +1323,16 @@ clcpp::Name clcpp::Database::GetName(const char* text) const
 
 const clcpp::Type* clcpp::Database::GetType(unsigned int hash) const
 {
-	return FindPrimitive(m_DatabaseMem->type_primitives, hash);
+	int index = HashTableSearch<const Type*, const Primitive*, GetPrimitivePtrHash>(m_DatabaseMem->type_primitive_table, m_DatabaseMem->type_primitives, hash);
+	if (index == -1)
+		return 0;
+	return m_DatabaseMem->type_primitives[index];
 }
 
 
 const clcpp::Namespace* clcpp::Database::GetNamespace(unsigned int hash) const
 {
-	int index = BinarySearch<Namespace, const Primitive&, GetPrimitiveHash>(m_DatabaseMem->namespaces, hash);
+	int index = HashTableSearch<Namespace, const Primitive&, GetPrimitiveHash>(m_DatabaseMem->namespace_table, m_DatabaseMem->namespaces, hash);
 	if (index == -1)
 		return 0;
 	return &m_DatabaseMem->namespaces[index];
@@ -693,7 +1347,7 @@ const clcpp::Namespace* clcpp::Database::GetGlobalNamespace() const
 
 const clcpp::Template* clcpp::Database::GetTemplate(unsigned int hash) const
 {
-	int index = BinarySearch<Template, const Primitive&, GetPrimitiveHash>(m_DatabaseMem->templates, hash);
+	int index = HashTableSearch<Template, const Primitive&, GetPrimitiveHash>(m_DatabaseMem->template_table, m_DatabaseMem->templates, hash);
 	if (index == -1)
 		return 0;
 	return &m_DatabaseMem->templates[index];
@@ -702,7 +1356,10 @@ const clcpp::Template* clcpp::Database::GetTemplate(unsigned int hash) const
 
 const clcpp::Function* clcpp::Database::GetFunction(unsigned int hash) const
 {
-	int index = BinarySearch<Function, const Primitive&, GetPrimitiveHash>(m_DatabaseMem->functions, hash);
+	if (!EnsureSectionLoaded(m_Sections, internal::DATABASE_SECTION_FUNCTIONS))
+		return 0;
+
+	int index = HashTableSearch<Function, const Primitive&, GetPrimitiveHash>(m_DatabaseMem->function_table, m_DatabaseMem->functions, hash);
 	if (index == -1)
 		return 0;
 	return &m_DatabaseMem->functions[index];
@@ -711,8 +1368,11 @@ const clcpp::Function* clcpp::Database::GetFunction(unsigned int hash) const
 
 clcpp::Range clcpp::Database::GetOverloadedFunction(unsigned int hash) const
 {
+	if (!EnsureSectionLoaded(m_Sections, internal::DATABASE_SECTION_FUNCTIONS))
+		return Range();
+
 	// Quickly locate the first match
-	int index = BinarySearch<Function, const Primitive&, GetPrimitiveHash>(m_DatabaseMem->functions, hash);
+	int index = HashTableSearch<Function, const Primitive&, GetPrimitiveHash>(m_DatabaseMem->function_table, m_DatabaseMem->functions, hash);
 	if (index == -1)
 		return Range();
 
@@ -731,10 +1391,23 @@ clcpp::internal::DatabaseMem::DatabaseMem()
 clcpp::internal::DatabaseFileHeader::DatabaseFileHeader()
 	: signature0('pclc')
 	, signature1('\0bdp')
-	, version(2)
+	, version(10)
+	, flags(0)
 	, nb_ptr_schemas(0)
 	, nb_ptr_offsets(0)
 	, nb_ptr_relocations(0)
+	, nb_ptr_links(0)
+	, data_offset(0)
 	, data_size(0)
+	, data_base(0)
 {
+	for (int i = 0; i < NB_DATABASE_SECTIONS; i++)
+	{
+		sections[i].data_offset = 0;
+		sections[i].data_size = 0;
+		sections[i].first_ptr_relocation = 0;
+		sections[i].nb_ptr_relocations = 0;
+		sections[i].file_offset = 0;
+		sections[i].file_size = 0;
+	}
 }
@@ -0,0 +1,136 @@
+
+//
+// ===============================================================================
+// clReflect
+// -------------------------------------------------------------------------------
+// Copyright (c) 2011-2012 Don Williamson & clReflect Authors (see AUTHORS file)
+// Released under MIT License (see LICENSE file)
+// ===============================================================================
+//
+
+#include "BlockCompressor.h"
+
+#include <clcpp/clcpp_internal.h>
+
+#include <cstring>
+
+
+namespace
+{
+	// Previous occurrences of each 4-byte sequence are found through a hash table
+	const int HASH_BITS = 14;
+	const size_t MIN_MATCH = 4;
+	const size_t MAX_OFFSET = 65535;
+
+	// Matches can't start within the last 12 bytes of a block or extend into its last 5,
+	// leaving the final sequence as literals only
+	const size_t MATCH_START_LIMIT = 12;
+	const size_t MATCH_END_LIMIT = 5;
+
+
+	unsigned int Read32(const unsigned char* data)
+	{
+		unsigned int value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+
+	unsigned int Hash(unsigned int value)
+	{
+		return (value * 2654435761U) >> (32 - HASH_BITS);
+	}
+
+
+	void WriteLength(std::vector<char>& output, size_t length)
+	{
+		// Lengths that don't fit in the token are continued with bytes of 255 until the remainder
+		for (; length >= 255; length -= 255)
+			output.push_back((char)255);
+		output.push_back((char)length);
+	}
+
+
+	void WriteSequence(std::vector<char>& output, const unsigned char* literals, size_t nb_literals, size_t offset, size_t match_length)
+	{
+		// The token packs the literal count and match length, less the minimum, into nibbles
+		size_t match_code = match_length ? match_length - MIN_MATCH : 0;
+		size_t token = (nb_literals < 15 ? nb_literals : 15) << 4 | (match_code < 15 ? match_code : 15);
+		output.push_back((char)token);
+		if (nb_literals >= 15)
+			WriteLength(output, nb_literals - 15);
+		output.insert(output.end(), literals, literals + nb_literals);
+
+		// The last sequence in a block has no match
+		if (match_length == 0)
+			return;
+
+		output.push_back((char)(offset & 0xFF));
+		output.push_back((char)(offset >> 8));
+		if (match_code >= 15)
+			WriteLength(output, match_code - 15);
+	}
+
+
+	void CompressBlock(const unsigned char* data, size_t size, std::vector<char>& output)
+	{
+		std::vector<int> table(1 << HASH_BITS, -1);
+		size_t anchor = 0;
+
+		if (size > MATCH_START_LIMIT)
+		{
+			size_t match_start_limit = size - MATCH_START_LIMIT;
+			size_t match_end_limit = size - MATCH_END_LIMIT;
+			size_t pos = 0;
+			while (pos < match_start_limit)
+			{
+				// Swap the position of this sequence into the table, checking the last one matches
+				unsigned int sequence = Read32(data + pos);
+				int& entry = table[Hash(sequence)];
+				int ref = entry;
+				entry = (int)pos;
+				if (ref == -1 || pos - ref > MAX_OFFSET || Read32(data + ref) != sequence)
+				{
+					pos++;
+					continue;
+				}
+
+				// Extend the match as far as possible and emit it along with any preceding literals
+				size_t length = MIN_MATCH;
+				while (pos + length < match_end_limit && data[ref + length] == data[pos + length])
+					length++;
+				WriteSequence(output, data + anchor, pos - anchor, pos - ref, length);
+				pos += length;
+				anchor = pos;
+			}
+		}
+
+		WriteSequence(output, data + anchor, size - anchor, 0, 0);
+	}
+}
+
+
+void CompressBlocks(const char* data, size_t size, std::vector<char>& output)
+{
+	std::vector<char> block;
+	for (size_t offset = 0; offset < size; offset += clcpp::internal::DATABASE_BLOCK_SIZE)
+	{
+		size_t block_size = size - offset;
+		if (block_size > clcpp::internal::DATABASE_BLOCK_SIZE)
+			block_size = clcpp::internal::DATABASE_BLOCK_SIZE;
+
+		// Store the block uncompressed if compression doesn't help
+		block.clear();
+		CompressBlock((const unsigned char*)data + offset, block_size, block);
+		clcpp::internal::DatabaseBlockHeader header;
+		header.data_size = block_size;
+		header.compressed_size = block.size() < block_size ? block.size() : block_size;
+
+		const char* header_data = (const char*)&header;
+		output.insert(output.end(), header_data, header_data + sizeof(header));
+		if (header.compressed_size == block_size)
+			output.insert(output.end(), data + offset, data + offset + block_size);
+		else
+			output.insert(output.end(), block.begin(), block.end());
+	}
+}
@@ -0,0 +1,24 @@
+
+//
+// ===============================================================================
+// clReflect, BlockCompressor.h - Fast LZ77 block compression of database files,
+// decompressed by the runtime as they're loaded.
+// -------------------------------------------------------------------------------
+// Copyright (c) 2011-2012 Don Williamson & clReflect Authors (see AUTHORS file)
+// Released under MIT License (see LICENSE file)
+// ===============================================================================
+//
+
+#pragma once
+
+
+#include <cstddef>
+#include <vector>
+
+
+//
+// Splits the data into blocks of DATABASE_BLOCK_SIZE, appending each to the output with a
+// DatabaseBlockHeader. Each block is encoded as a sequence of LZ4-style literal runs and
+// back-references, or stored uncompressed if that would make it any bigger.
+//
+void CompressBlocks(const char* data, size_t size, std::vector<char>& output);
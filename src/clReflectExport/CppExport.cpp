@@ -17,6 +17,7 @@
 
 #include "CppExport.h"
 #include "PtrRelocator.h"
+#include "BlockCompressor.h"
 
 #include <clReflectCore/Database.h>
 #include <clReflectCore/Logging.h>
@@ -282,7 +283,7 @@ namespace
 
 
 	template <typename PARENT_TYPE, typename CHILD_TYPE>
-	void Parent(ParentMap<PARENT_TYPE>& parents, clcpp::CArray<const CHILD_TYPE*> (PARENT_TYPE::*carray), clcpp::CArray<CHILD_TYPE*>& children, StackAllocator& allocator)
+	void Parent(ParentMap<PARENT_TYPE>& parents, clcpp::PrimitiveArray<CHILD_TYPE> (PARENT_TYPE::*carray), clcpp::CArray<CHILD_TYPE*>& children, StackAllocator& allocator)
 	{
 		parents.ResetRefCount();
 
@@ -345,7 +346,7 @@ namespace
 	}
 
 	template <typename PARENT_TYPE, typename CHILD_TYPE>
-	void Parent(ParentMap<PARENT_TYPE>& parents, clcpp::CArray<const CHILD_TYPE*> (PARENT_TYPE::*carray), clcpp::CArray<CHILD_TYPE>& children, StackAllocator& allocator)
+	void Parent(ParentMap<PARENT_TYPE>& parents, clcpp::PrimitiveArray<CHILD_TYPE> (PARENT_TYPE::*carray), clcpp::CArray<CHILD_TYPE>& children, StackAllocator& allocator)
 	{
 		// Create an array of pointers to the children and forward that to the Parent function
 		// that acts on arrays of pointers
@@ -574,6 +575,201 @@ namespace
 	}
 
 
+	typedef std::multimap<const clcpp::Type*, clcpp::Type*> DerivedTypeMap;
+
+
+	void NumberInheritanceTree(clcpp::Type* type, const DerivedTypeMap& derived_types, unsigned int& dfs_index)
+	{
+		// Pre-order number this type and then number all types that have it as their first base
+		type->dfs_first = ++dfs_index;
+		std::pair<DerivedTypeMap::const_iterator, DerivedTypeMap::const_iterator> range = derived_types.equal_range(type);
+		for (DerivedTypeMap::const_iterator i = range.first; i != range.second; ++i)
+			NumberInheritanceTree(i->second, derived_types, dfs_index);
+		type->dfs_last = dfs_index;
+	}
+
+
+	void GatherAncestors(const clcpp::Type* type, std::vector<const clcpp::Type*>& ancestors)
+	{
+		for (unsigned int i = 0; i < type->base_types.size; i++)
+		{
+			const clcpp::Type* base_type = type->base_types[i];
+			if (std::find(ancestors.begin(), ancestors.end(), base_type) == ancestors.end())
+			{
+				ancestors.push_back(base_type);
+				GatherAncestors(base_type, ancestors);
+			}
+		}
+	}
+
+
+	void BuildInheritanceIntervals(CppExport& cppexp)
+	{
+		clcpp::CArray<const clcpp::Type*>& types = cppexp.db->type_primitives;
+
+		// Build the forest formed by the first base of each type and number it depth-first
+		DerivedTypeMap derived_types;
+		for (unsigned int i = 0; i < types.size; i++)
+		{
+			const clcpp::Type* type = types[i];
+			if (type->base_types.size)
+				derived_types.insert(DerivedTypeMap::value_type(type->base_types[0], const_cast<clcpp::Type*>(type)));
+		}
+		unsigned int dfs_index = 0;
+		for (unsigned int i = 0; i < types.size; i++)
+		{
+			if (types[i]->base_types.size == 0)
+				NumberInheritanceTree(const_cast<clcpp::Type*>(types[i]), derived_types, dfs_index);
+		}
+
+		// Find all ancestors of each type that can't be found with an interval check
+		unsigned int nb_secondary_bases = 0;
+		std::vector<const clcpp::Type*> ancestors;
+		for (unsigned int i = 0; i < types.size; i++)
+		{
+			clcpp::Type* type = const_cast<clcpp::Type*>(types[i]);
+			ancestors.clear();
+			GatherAncestors(type, ancestors);
+
+			std::vector<unsigned int> bits;
+			for (size_t j = 0; j < ancestors.size(); j++)
+			{
+				clcpp::Type* ancestor = const_cast<clcpp::Type*>(ancestors[j]);
+				if (type->dfs_first >= ancestor->dfs_first && type->dfs_first <= ancestor->dfs_last)
+					continue;
+
+				// Assign indices to secondary bases as they're encountered
+				if (ancestor->secondary_base_index == 0)
+					ancestor->secondary_base_index = ++nb_secondary_bases;
+				unsigned int index = ancestor->secondary_base_index - 1;
+				if ((index >> 5) >= bits.size())
+					bits.resize((index >> 5) + 1, 0);
+				bits[index >> 5] |= 1U << (index & 31);
+			}
+
+			// Only store as many words as are needed for the highest bit set
+			if (bits.size())
+			{
+				cppexp.allocator.Alloc(type->secondary_bases, bits.size());
+				for (size_t j = 0; j < bits.size(); j++)
+					type->secondary_bases[j] = bits[j];
+			}
+		}
+	}
+
+
+	bool ConstantValueLess(const clcpp::EnumConstant* a, const clcpp::EnumConstant* b)
+	{
+		return a->value < b->value;
+	}
+
+
+	void BuildEnumValueTables(CppExport& cppexp)
+	{
+		static const unsigned int flags_hash = CLCPP_NAME_HASH("flags");
+
+		std::vector<const clcpp::EnumConstant*> constants;
+		for (unsigned int i = 0; i < cppexp.db->enums.size; i++)
+		{
+			clcpp::Enum& enum_type = cppexp.db->enums[i];
+			if (enum_type.constants.size == 0)
+				continue;
+
+			// Sort by value, keeping constants with equal values in name order so that searches
+			// find the same constant as a linear search of the name-sorted array
+			constants.assign(enum_type.constants.data, enum_type.constants.data + enum_type.constants.size);
+			std::stable_sort(constants.begin(), constants.end(), ConstantValueLess);
+			cppexp.allocator.Alloc(enum_type.constants_by_value, constants.size());
+			for (size_t j = 0; j < constants.size(); j++)
+				enum_type.constants_by_value[j] = constants[j];
+
+			// Use a direct lookup table if it's no more than twice the size of the constant array
+			long long min_value = constants.front()->value;
+			long long range = (long long)constants.back()->value - min_value + 1;
+			if (range <= (long long)constants.size() * 2)
+			{
+				enum_type.value_table_base = (int)min_value;
+				cppexp.allocator.Alloc(enum_type.value_table, (int)range);
+				for (size_t j = constants.size(); j-- > 0; )
+					enum_type.value_table[(unsigned int)(constants[j]->value - min_value)] = constants[j];
+			}
+
+			// Record the constant for each single-bit value of flags enums
+			if (clcpp::FindPrimitive(enum_type.attributes, flags_hash) == 0)
+				continue;
+			const clcpp::EnumConstant* flag_constants[32] = { 0 };
+			int nb_flag_constants = 0;
+			for (size_t j = constants.size(); j-- > 0; )
+			{
+				unsigned int value = (unsigned int)constants[j]->value;
+				if (value == 0 || (value & (value - 1)) != 0)
+					continue;
+				int bit = 0;
+				while ((value >> bit) != 1)
+					bit++;
+				flag_constants[bit] = constants[j];
+				if (bit >= nb_flag_constants)
+					nb_flag_constants = bit + 1;
+			}
+			if (nb_flag_constants != 0)
+			{
+				cppexp.allocator.Alloc(enum_type.flag_constants, nb_flag_constants);
+				for (int j = 0; j < nb_flag_constants; j++)
+					enum_type.flag_constants[j] = flag_constants[j];
+			}
+		}
+	}
+
+
+	bool FieldOffsetLess(const clcpp::Field* a, const clcpp::Field* b)
+	{
+		return a->offset < b->offset;
+	}
+
+
+	bool GatherFlattenedFields(const clcpp::Type* type, std::vector<const clcpp::Field*>& fields)
+	{
+		// Containers have to be visited through their type so can't be flattened
+		if (type->kind == clcpp::Primitive::KIND_TEMPLATE_TYPE && type->ci != 0)
+			return false;
+
+		// Base types share the address of the derived type and come first
+		for (unsigned int i = 0; i < type->base_types.size; i++)
+		{
+			if (!GatherFlattenedFields(type->base_types[i], fields))
+				return false;
+		}
+
+		// Template types have no fields; just bases
+		if (type->kind == clcpp::Primitive::KIND_CLASS)
+		{
+			const clcpp::Class* class_type = (const clcpp::Class*)type;
+			size_t first = fields.size();
+			fields.insert(fields.end(), class_type->fields.data, class_type->fields.data + class_type->fields.size);
+			std::stable_sort(fields.begin() + first, fields.end(), FieldOffsetLess);
+		}
+
+		return true;
+	}
+
+
+	void BuildFlattenedFields(CppExport& cppexp)
+	{
+		std::vector<const clcpp::Field*> fields;
+		for (unsigned int i = 0; i < cppexp.db->classes.size; i++)
+		{
+			clcpp::Class& class_type = cppexp.db->classes[i];
+			fields.clear();
+			if (!GatherFlattenedFields(&class_type, fields) || fields.empty())
+				continue;
+
+			cppexp.allocator.Alloc(class_type.flattened_fields, fields.size());
+			for (size_t j = 0; j < fields.size(); j++)
+				class_type.flattened_fields[j] = fields[j];
+		}
+	}
+
+
 	int ReturnParameterIndex(const clcpp::CArray<const clcpp::Field*>& parameters)
 	{
 		// Linear search for the named return value
@@ -621,7 +817,7 @@ namespace
 
 
 	template <typename TYPE>
-	void GatherGlobalPrimitives(clcpp::CArray<const TYPE*>& dest, const clcpp::CArray<TYPE>& src, StackAllocator& allocator)
+	void GatherGlobalPrimitives(clcpp::PrimitiveArray<TYPE>& dest, const clcpp::CArray<TYPE>& src, StackAllocator& allocator)
 	{
 		// Allocate enough space for the primitives
 		int nb_global_primitives = CountGlobalPrimitives(src);
@@ -996,7 +1192,21 @@ namespace
 	}
 
 
-	void RemoveInvalidFields(clcpp::CArray<const clcpp::Field*>& fields)
+	template <typename TYPE>
+	void UpdatePrimitiveHashes(clcpp::PrimitiveArray<TYPE>& primitives)
+	{
+		// Rewrite the hashes of an array that has shrunk since they were built, in place
+	#if !defined(CLCPP_COMPACT_LAYOUT)
+		if (primitives.size == 0)
+			primitives.hashes = 0;
+	#endif
+		unsigned int* hashes = (unsigned int*)primitives.GetHashes();
+		for (unsigned int i = 0; i < primitives.size; i++)
+			hashes[i] = primitives[i]->name.hash;
+	}
+
+
+	void RemoveInvalidFields(clcpp::PrimitiveArray<clcpp::Field>& fields)
 	{
 		// Remove invalid fields, leaving the memory allocated
 		for (unsigned int i = 0; i < fields.size; )
@@ -1007,10 +1217,11 @@ namespace
 			else
 				i++;
 		}
+		UpdatePrimitiveHashes(fields);
 	}
 
 
-	void RemoveInvalidFunctions(clcpp::CArray<const clcpp::Function*>& functions)
+	void RemoveInvalidFunctions(clcpp::PrimitiveArray<clcpp::Function>& functions)
 	{
 		for (unsigned int i = 0; i < functions.size; )
 		{
@@ -1035,6 +1246,7 @@ namespace
 			else
 				i++;
 		}
+		UpdatePrimitiveHashes(functions);
 	}
 
 
@@ -1055,17 +1267,214 @@ namespace
 			RemoveInvalidFunctions(primitive.functions);
 		}
 	}
+
+
+	unsigned int GetEntryHash(const clcpp::Name& name)
+	{
+		return name.hash;
+	}
+	unsigned int GetEntryHash(const clcpp::Primitive& primitive)
+	{
+		return primitive.name.hash;
+	}
+	unsigned int GetEntryHash(const clcpp::Primitive* primitive)
+	{
+		return primitive->name.hash;
+	}
+
+
+	// Sort buckets by decreasing number of keys
+	typedef std::pair<unsigned int, std::vector<unsigned int> > HashBucket;
+	bool SortBucketBySize(const HashBucket& a, const HashBucket& b)
+	{
+		return a.second.size() > b.second.size();
+	}
+
+
+	template <typename TYPE>
+	void BuildHashTable(CppExport& cppexp, clcpp::internal::HashTable& table, const clcpp::CArray<TYPE>& entries, const char* table_name)
+	{
+		// Gather all unique hashes, mapping overloaded primitives to the first of their run
+		// in the sorted array so that the runtime can search its neighbours
+		std::vector<unsigned int> keys, key_indices;
+		for (unsigned int i = 0; i < entries.size; i++)
+		{
+			unsigned int hash = GetEntryHash(entries[i]);
+			if (keys.empty() || keys.back() != hash)
+			{
+				keys.push_back(hash);
+				key_indices.push_back(i);
+			}
+		}
+		if (keys.empty())
+			return;
+
+		// Distribute keys among buckets with an average of 4 keys per bucket
+		unsigned int nb_slots = keys.size();
+		unsigned int nb_buckets = (nb_slots + 3) / 4;
+		std::vector<HashBucket> buckets(nb_buckets);
+		for (unsigned int i = 0; i < nb_buckets; i++)
+			buckets[i].first = i;
+		for (unsigned int i = 0; i < keys.size(); i++)
+			buckets[clcpp::internal::HashTable::GetBucket(keys[i], nb_buckets)].second.push_back(i);
+
+		// Place the largest buckets first while most slots are still free
+		std::stable_sort(buckets.begin(), buckets.end(), SortBucketBySize);
+
+		std::vector<unsigned int> seeds(nb_buckets, 0);
+		std::vector<int> slots(nb_slots, -1);
+		std::vector<unsigned int> bucket_slots;
+		for (unsigned int i = 0; i < nb_buckets && !buckets[i].second.empty(); i++)
+		{
+			const std::vector<unsigned int>& bucket_keys = buckets[i].second;
+
+			// Search for a seed that displaces all keys in the bucket to unique, free slots
+			unsigned int seed = 0;
+			for ( ; seed < 0x1000000; seed++)
+			{
+				bucket_slots.clear();
+				for (unsigned int j = 0; j < bucket_keys.size(); j++)
+				{
+					unsigned int slot = clcpp::internal::HashTable::GetSlot(keys[bucket_keys[j]], seed, nb_slots);
+					if (slots[slot] != -1 || std::find(bucket_slots.begin(), bucket_slots.end(), slot) != bucket_slots.end())
+						break;
+					bucket_slots.push_back(slot);
+				}
+				if (bucket_slots.size() == bucket_keys.size())
+					break;
+			}
+
+			// Leave the table empty so that the runtime falls back to a binary search
+			if (seed == 0x1000000)
+			{
+				LOG(main, WARNING, "Couldn't build perfect hash table for %s\n", table_name);
+				return;
+			}
+
+			seeds[buckets[i].first] = seed;
+			for (unsigned int j = 0; j < bucket_keys.size(); j++)
+				slots[bucket_slots[j]] = key_indices[bucket_keys[j]];
+		}
+
+		// Copy to the memory map
+		cppexp.allocator.Alloc(table.seeds, nb_buckets);
+		for (unsigned int i = 0; i < nb_buckets; i++)
+			table.seeds[i] = seeds[i];
+		cppexp.allocator.Alloc(table.indices, nb_slots);
+		for (unsigned int i = 0; i < nb_slots; i++)
+			table.indices[i] = slots[i];
+	}
+
+
+	template <typename TYPE>
+	void BuildPrimitiveHashes(clcpp::PrimitiveArray<TYPE>& primitives, StackAllocator& allocator)
+	{
+		if (primitives.size == 0)
+			return;
+
+		// Copy the name hash of each primitive into its parallel array, which has already been
+		// allocated after the primitive pointers in the compact layout
+	#if defined(CLCPP_COMPACT_LAYOUT)
+		unsigned int* hashes = (unsigned int*)primitives.GetHashes();
+	#else
+		unsigned int* hashes = allocator.Alloc<unsigned int>(primitives.size);
+		primitives.hashes = hashes;
+	#endif
+		for (unsigned int i = 0; i < primitives.size; i++)
+			hashes[i] = primitives[i]->name.hash;
+	}
+
+
+	// Overloads for building the hash arrays within a primitive
+	void BuildPrimitiveHashes(clcpp::Enum& primitive, StackAllocator& allocator)
+	{
+		BuildPrimitiveHashes(primitive.constants, allocator);
+		BuildPrimitiveHashes(primitive.attributes, allocator);
+	}
+	void BuildPrimitiveHashes(clcpp::Field& primitive, StackAllocator& allocator)
+	{
+		BuildPrimitiveHashes(primitive.attributes, allocator);
+	}
+	void BuildPrimitiveHashes(clcpp::Function& primitive, StackAllocator& allocator)
+	{
+		BuildPrimitiveHashes(primitive.parameters, allocator);
+		BuildPrimitiveHashes(primitive.attributes, allocator);
+	}
+	void BuildPrimitiveHashes(clcpp::Class& primitive, StackAllocator& allocator)
+	{
+		BuildPrimitiveHashes(primitive.enums, allocator);
+		BuildPrimitiveHashes(primitive.classes, allocator);
+		BuildPrimitiveHashes(primitive.methods, allocator);
+		BuildPrimitiveHashes(primitive.fields, allocator);
+		BuildPrimitiveHashes(primitive.attributes, allocator);
+		BuildPrimitiveHashes(primitive.templates, allocator);
+	}
+	void BuildPrimitiveHashes(clcpp::Template& primitive, StackAllocator& allocator)
+	{
+		BuildPrimitiveHashes(primitive.instances, allocator);
+	}
+	void BuildPrimitiveHashes(clcpp::Namespace& primitive, StackAllocator& allocator)
+	{
+		BuildPrimitiveHashes(primitive.namespaces, allocator);
+		BuildPrimitiveHashes(primitive.types, allocator);
+		BuildPrimitiveHashes(primitive.enums, allocator);
+		BuildPrimitiveHashes(primitive.classes, allocator);
+		BuildPrimitiveHashes(primitive.functions, allocator);
+		BuildPrimitiveHashes(primitive.templates, allocator);
+	}
+
+
+	// Iterate over all provided primitives and build their hash arrays
+	template <typename TYPE>
+	void BuildPrimitiveHashes(clcpp::CArray<TYPE>& primitives, StackAllocator& allocator)
+	{
+		for (unsigned int i = 0; i < primitives.size; i++)
+			BuildPrimitiveHashes(primitives[i], allocator);
+	}
+
+
+	void BuildHashTables(CppExport& cppexp)
+	{
+		// Each table is stored in the same section as the array it indexes
+		StackAllocator& allocator = cppexp.allocator;
+		allocator.SetSection(clcpp::internal::DATABASE_SECTION_NAMES);
+		BuildHashTable(cppexp, cppexp.db->name_table, cppexp.db->names, "names");
+		allocator.SetSection(clcpp::internal::DATABASE_SECTION_FUNCTIONS);
+		BuildHashTable(cppexp, cppexp.db->function_table, cppexp.db->functions, "functions");
+		allocator.SetSection(clcpp::internal::DATABASE_SECTION_TYPES);
+		BuildHashTable(cppexp, cppexp.db->type_primitive_table, cppexp.db->type_primitives, "types");
+		BuildHashTable(cppexp, cppexp.db->template_table, cppexp.db->templates, "templates");
+		BuildHashTable(cppexp, cppexp.db->namespace_table, cppexp.db->namespaces, "namespaces");
+	}
+
+
+	template <typename TYPE>
+	void AppendData(std::vector<char>& output, const std::vector<TYPE>& data)
+	{
+		if (data.size())
+		{
+			const char* bytes = (const char*)&data.front();
+			output.insert(output.end(), bytes, bytes + data.size() * sizeof(TYPE));
+		}
+	}
 }
 
 
 bool BuildCppExport(const cldb::Database& db, CppExport& cppexp)
 {
+	// Allocations are grouped into sections of the memory map that the runtime can load
+	// independently. Each allocation goes in the section of the primitive that owns it, with
+	// everything else in the types section, which the database object itself must start.
+	cppexp.allocator.SetSection(clcpp::internal::DATABASE_SECTION_TYPES);
+
 	// Allocate the in-memory database
 	cppexp.db = cppexp.allocator.Alloc<clcpp::internal::DatabaseMem>(1);
 	cppexp.db->function_base_address = cppexp.function_base_address;
 
 	// Build all the name data ready for the client to use and the exporter to debug with
+	cppexp.allocator.SetSection(clcpp::internal::DATABASE_SECTION_NAMES);
 	BuildNames(db, cppexp);
+	cppexp.allocator.SetSection(clcpp::internal::DATABASE_SECTION_TYPES);
 
 	// Generate a raw clcpp equivalent of the cldb database. At this point no primitives
 	// will physically point to or contain each other, but they will reference each other
@@ -1074,20 +1483,23 @@ bool BuildCppExport(const cldb::Database& db, CppExport& cppexp)
 	BuildCArray<cldb::EnumConstant>(cppexp, cppexp.db->enum_constants, db);
 	BuildCArray<cldb::Enum>(cppexp, cppexp.db->enums, db);
 	BuildCArray<cldb::Field>(cppexp, cppexp.db->fields, db);
-	BuildCArray<cldb::Function>(cppexp, cppexp.db->functions, db);
 	BuildCArray<cldb::Class>(cppexp, cppexp.db->classes, db);
 	BuildCArray<cldb::Template>(cppexp, cppexp.db->templates, db);
 	BuildCArray<cldb::TemplateType>(cppexp, cppexp.db->template_types, db);
 	BuildCArray<cldb::Namespace>(cppexp, cppexp.db->namespaces, db);
+	BuildCArray<cldb::ContainerInfo>(cppexp, cppexp.db->container_infos, db);
+	cppexp.allocator.SetSection(clcpp::internal::DATABASE_SECTION_FUNCTIONS);
+	BuildCArray<cldb::Function>(cppexp, cppexp.db->functions, db);
+	cppexp.allocator.SetSection(clcpp::internal::DATABASE_SECTION_ATTRIBUTES);
 	BuildCArray<cldb::FlagAttribute>(cppexp, cppexp.db->flag_attributes, db);
 	BuildCArray<cldb::IntAttribute>(cppexp, cppexp.db->int_attributes, db);
 	BuildCArray<cldb::FloatAttribute>(cppexp, cppexp.db->float_attributes, db);
 	BuildCArray<cldb::PrimitiveAttribute>(cppexp, cppexp.db->primitive_attributes, db);
 	BuildCArray<cldb::TextAttribute>(cppexp, cppexp.db->text_attributes, db);
-	BuildCArray<cldb::ContainerInfo>(cppexp, cppexp.db->container_infos, db);
 
 	// Now ensure all text data is pointing into the data to be memory mapped
 	AssignAttributeText(cppexp);
+	cppexp.allocator.SetSection(clcpp::internal::DATABASE_SECTION_TYPES);
 
 	// Generate a list of references to all type primitives so that runtime serialisation code
 	// can quickly look them up.
@@ -1103,7 +1515,9 @@ bool BuildCppExport(const cldb::Database& db, CppExport& cppexp)
 	// Construct the primitive scope hierarchy, pointing primitives at their parents
 	// and adding them to the arrays within their parents.
 	Parent(enum_parents, &clcpp::Enum::constants, cppexp.db->enum_constants, cppexp.allocator);
+	cppexp.allocator.SetSection(clcpp::internal::DATABASE_SECTION_FUNCTIONS);
 	Parent(function_parents, &clcpp::Function::parameters, cppexp.db->fields, cppexp.allocator);
+	cppexp.allocator.SetSection(clcpp::internal::DATABASE_SECTION_TYPES);
 	Parent(class_parents, &clcpp::Class::enums, cppexp.db->enums, cppexp.allocator);
 	Parent(class_parents, &clcpp::Class::classes, cppexp.db->classes, cppexp.allocator);
 	Parent(class_parents, &clcpp::Class::methods, cppexp.db->functions, cppexp.allocator);
@@ -1124,11 +1538,15 @@ bool BuildCppExport(const cldb::Database& db, CppExport& cppexp)
 	// Construct the primitive hierarchy for attributes by first collecting all attributes into
 	// a single pointer array
 	clcpp::CArray<clcpp::Attribute*> attributes;
+	cppexp.allocator.SetSection(clcpp::internal::DATABASE_SECTION_ATTRIBUTES);
 	BuildAttributePtrArray(cppexp, attributes);
+	cppexp.allocator.SetSection(clcpp::internal::DATABASE_SECTION_TYPES);
 	Parent(enum_parents, &clcpp::Enum::attributes, attributes, cppexp.allocator);
 	Parent(field_parents, &clcpp::Field::attributes, attributes, cppexp.allocator);
-	Parent(function_parents, &clcpp::Function::attributes, attributes, cppexp.allocator);
 	Parent(class_parents, &clcpp::Class::attributes, attributes, cppexp.allocator);
+	cppexp.allocator.SetSection(clcpp::internal::DATABASE_SECTION_FUNCTIONS);
+	Parent(function_parents, &clcpp::Function::attributes, attributes, cppexp.allocator);
+	cppexp.allocator.SetSection(clcpp::internal::DATABASE_SECTION_TYPES);
 
 	// Link up any references between primitives
 	Link(cppexp.db->fields, &clcpp::Field::type, cppexp.db->type_primitives);
@@ -1153,6 +1571,20 @@ bool BuildCppExport(const cldb::Database& db, CppExport& cppexp)
 	SortPrimitives(cppexp.db->namespaces);
 	SortPrimitives(cppexp.db->type_primitives);
 
+	// Give each primitive's child arrays a parallel array of name hashes so that they can be
+	// searched without dereferencing each primitive. This has to happen before anything below
+	// uses clcpp::FindPrimitive, which searches the hashes. Arrays that shrink when invalid
+	// primitives are removed update their hashes in place.
+	BuildPrimitiveHashes(cppexp.db->enums, cppexp.allocator);
+	BuildPrimitiveHashes(cppexp.db->fields, cppexp.allocator);
+	BuildPrimitiveHashes(cppexp.db->classes, cppexp.allocator);
+	BuildPrimitiveHashes(cppexp.db->templates, cppexp.allocator);
+	BuildPrimitiveHashes(cppexp.db->namespaces, cppexp.allocator);
+	BuildPrimitiveHashes(cppexp.db->global_namespace, cppexp.allocator);
+	cppexp.allocator.SetSection(clcpp::internal::DATABASE_SECTION_FUNCTIONS);
+	BuildPrimitiveHashes(cppexp.db->functions, cppexp.allocator);
+	cppexp.allocator.SetSection(clcpp::internal::DATABASE_SECTION_TYPES);
+
 	// Container infos need to be parented to their owners and their read/writer iterator
 	// pointers need to be linked to their reflected types
 	LinkContainerInfos(cppexp, field_parents);
@@ -1160,6 +1592,9 @@ bool BuildCppExport(const cldb::Database& db, CppExport& cppexp)
 	// Build base classes arrays after the type primitive array has been sorted
 	BuildBaseClassArrays(cppexp, db);
 
+	// Number the inheritance hierarchy for constant-time subtype checks
+	BuildInheritanceIntervals(cppexp);
+
 	// Each class may have constructor/destructor methods in their method list. Run through
 	// each class and make pointers to these in the class. This is done after sorting so that
 	// local searches can take advantage of clcpp::FindPrimitive.
@@ -1190,13 +1625,24 @@ bool BuildCppExport(const cldb::Database& db, CppExport& cppexp)
 	// if you compile is without warnings!
 	IsolateInvalidPrimitives(cppexp);
 
+	// Flatten the fields of each class and its bases into declaration order so that they can
+	// be serialised without recursing through the inheritance hierarchy. This has to happen
+	// after invalid fields and base types have been removed.
+	BuildFlattenedFields(cppexp);
+
+	// Index the constants of each enum by value for fast conversion of values to names
+	BuildEnumValueTables(cppexp);
+
+	// Build constant-time lookup tables for the database arrays that are searched by name
+	BuildHashTables(cppexp);
+
 	return true;
 }
 
 
 void SaveCppExport(CppExport& cppexp, const char* filename)
 {
-	PtrRelocator relocator(cppexp.allocator.GetData(), cppexp.allocator.GetAllocatedSize());
+	PtrRelocator relocator(cppexp.allocator);
 
 	// The position of the data member within a CArray is fixed, independent of type
 	size_t array_ofs = array_data_offset();
@@ -1207,6 +1653,11 @@ void SaveCppExport(CppExport& cppexp, const char* filename)
 		size_t global_namespace_offset = offsetof(clcpp::internal::DatabaseMem, global_namespace);
 		size_t name_offset_in_primitive = offsetof(clcpp::Primitive, name);
 		size_t name_offset_in_container_info = offsetof(clcpp::ContainerInfo, name);
+		size_t seeds_offset_in_hash_table = offsetof(clcpp::internal::HashTable, seeds);
+		size_t indices_offset_in_hash_table = offsetof(clcpp::internal::HashTable, indices);
+		#if !defined(CLCPP_COMPACT_LAYOUT)
+			size_t hashes_ofs = offsetof(clcpp::PrimitiveArray<clcpp::Primitive>, hashes);
+		#endif
 	#else
 		clcpp::internal::DatabaseMem dummyDatabaseMem;
 		clcpp::Primitive dummyPrimitive(clcpp::Primitive::KIND_NONE);
@@ -1215,6 +1666,11 @@ void SaveCppExport(CppExport& cppexp, const char* filename)
 		size_t global_namespace_offset = ((size_t) (&(dummyDatabaseMem.global_namespace))) - ((size_t) (&dummyDatabaseMem));
 		size_t name_offset_in_primitive = ((size_t) (&(dummyPrimitive.name))) - ((size_t) (&dummyPrimitive));
 		size_t name_offset_in_container_info = ((size_t) (&(dummyContainerInfo.name))) - ((size_t) (&dummyContainerInfo));
+		size_t seeds_offset_in_hash_table = ((size_t) (&(dummyDatabaseMem.name_table.seeds))) - ((size_t) (&dummyDatabaseMem.name_table));
+		size_t indices_offset_in_hash_table = ((size_t) (&(dummyDatabaseMem.name_table.indices))) - ((size_t) (&dummyDatabaseMem.name_table));
+		#if !defined(CLCPP_COMPACT_LAYOUT)
+			size_t hashes_ofs = ((size_t) (&(dummyDatabaseMem.global_namespace.types.hashes))) - ((size_t) (&dummyDatabaseMem.global_namespace.types));
+		#endif
 	#endif
 
 	// Construct schemas for all memory-mapped clcpp types
@@ -1239,11 +1695,22 @@ void SaveCppExport(CppExport& cppexp, const char* filename)
 		(&clcpp::internal::DatabaseMem::text_attributes, array_ofs)
 		(&clcpp::internal::DatabaseMem::type_primitives, array_ofs)
 		(&clcpp::internal::DatabaseMem::container_infos, array_ofs)
+		(&clcpp::internal::DatabaseMem::name_table, array_ofs + seeds_offset_in_hash_table)
+		(&clcpp::internal::DatabaseMem::name_table, array_ofs + indices_offset_in_hash_table)
+		(&clcpp::internal::DatabaseMem::type_primitive_table, array_ofs + seeds_offset_in_hash_table)
+		(&clcpp::internal::DatabaseMem::type_primitive_table, array_ofs + indices_offset_in_hash_table)
+		(&clcpp::internal::DatabaseMem::function_table, array_ofs + seeds_offset_in_hash_table)
+		(&clcpp::internal::DatabaseMem::function_table, array_ofs + indices_offset_in_hash_table)
+		(&clcpp::internal::DatabaseMem::template_table, array_ofs + seeds_offset_in_hash_table)
+		(&clcpp::internal::DatabaseMem::template_table, array_ofs + indices_offset_in_hash_table)
+		(&clcpp::internal::DatabaseMem::namespace_table, array_ofs + seeds_offset_in_hash_table)
+		(&clcpp::internal::DatabaseMem::namespace_table, array_ofs + indices_offset_in_hash_table)
 		(&clcpp::Namespace::namespaces, array_ofs + global_namespace_offset)
 		(&clcpp::Namespace::types, array_ofs + global_namespace_offset)
 		(&clcpp::Namespace::enums, array_ofs + global_namespace_offset)
 		(&clcpp::Namespace::classes, array_ofs + global_namespace_offset)
-		(&clcpp::Namespace::functions, array_ofs + global_namespace_offset);
+		(&clcpp::Namespace::functions, array_ofs + global_namespace_offset)
+		(&clcpp::Namespace::templates, array_ofs + global_namespace_offset);
 
 	PtrSchema& schema_name = relocator.AddSchema<clcpp::Name>()
 		(&clcpp::Name::text);
@@ -1254,13 +1721,17 @@ void SaveCppExport(CppExport& cppexp, const char* filename)
 
 	PtrSchema& schema_type = relocator.AddSchema<clcpp::Type>(&schema_primitive)
 		(&clcpp::Type::base_types, array_ofs)
-		(&clcpp::Type::ci);
+		(&clcpp::Type::ci)
+		(&clcpp::Type::secondary_bases, array_ofs);
 
 	PtrSchema& schema_enum_constant = relocator.AddSchema<clcpp::EnumConstant>(&schema_primitive);
 
 	PtrSchema& schema_enum = relocator.AddSchema<clcpp::Enum>(&schema_type)
 		(&clcpp::Enum::constants, array_ofs)
-		(&clcpp::Enum::attributes, array_ofs);
+		(&clcpp::Enum::attributes, array_ofs)
+		(&clcpp::Enum::constants_by_value, array_ofs)
+		(&clcpp::Enum::value_table, array_ofs)
+		(&clcpp::Enum::flag_constants, array_ofs);
 
 	PtrSchema& schema_field = relocator.AddSchema<clcpp::Field>(&schema_primitive)
 		(&clcpp::Field::type)
@@ -1280,7 +1751,8 @@ void SaveCppExport(CppExport& cppexp, const char* filename)
 		(&clcpp::Class::methods, array_ofs)
 		(&clcpp::Class::fields, array_ofs)
 		(&clcpp::Class::attributes, array_ofs)
-		(&clcpp::Class::templates, array_ofs);
+		(&clcpp::Class::templates, array_ofs)
+		(&clcpp::Class::flattened_fields, array_ofs);
 
 	PtrSchema& schema_template_type = relocator.AddSchema<clcpp::TemplateType>(&schema_type)
 		(&clcpp::TemplateType::parameter_types, sizeof(void*) * 0)
@@ -1315,6 +1787,42 @@ void SaveCppExport(CppExport& cppexp, const char* filename)
 		(&clcpp::ContainerInfo::read_iterator_type)
 		(&clcpp::ContainerInfo::write_iterator_type);
 
+	// Pointers to the parallel name hash arrays, which aren't needed in the compact layout
+	// as the hashes directly follow the primitive pointers
+	#if !defined(CLCPP_COMPACT_LAYOUT)
+	schema_database
+		(&clcpp::Namespace::namespaces, hashes_ofs + global_namespace_offset)
+		(&clcpp::Namespace::types, hashes_ofs + global_namespace_offset)
+		(&clcpp::Namespace::enums, hashes_ofs + global_namespace_offset)
+		(&clcpp::Namespace::classes, hashes_ofs + global_namespace_offset)
+		(&clcpp::Namespace::functions, hashes_ofs + global_namespace_offset)
+		(&clcpp::Namespace::templates, hashes_ofs + global_namespace_offset);
+	schema_enum
+		(&clcpp::Enum::constants, hashes_ofs)
+		(&clcpp::Enum::attributes, hashes_ofs);
+	schema_field
+		(&clcpp::Field::attributes, hashes_ofs);
+	schema_function
+		(&clcpp::Function::parameters, hashes_ofs)
+		(&clcpp::Function::attributes, hashes_ofs);
+	schema_class
+		(&clcpp::Class::enums, hashes_ofs)
+		(&clcpp::Class::classes, hashes_ofs)
+		(&clcpp::Class::methods, hashes_ofs)
+		(&clcpp::Class::fields, hashes_ofs)
+		(&clcpp::Class::attributes, hashes_ofs)
+		(&clcpp::Class::templates, hashes_ofs);
+	schema_template
+		(&clcpp::Template::instances, hashes_ofs);
+	schema_namespace
+		(&clcpp::Namespace::namespaces, hashes_ofs)
+		(&clcpp::Namespace::types, hashes_ofs)
+		(&clcpp::Namespace::enums, hashes_ofs)
+		(&clcpp::Namespace::classes, hashes_ofs)
+		(&clcpp::Namespace::functions, hashes_ofs)
+		(&clcpp::Namespace::templates, hashes_ofs);
+	#endif
+
 	// Add pointers from the base database object
 	relocator.AddPointers(schema_database, cppexp.db);
 	relocator.AddPointers(schema_name, cppexp.db->names);
@@ -1344,6 +1852,9 @@ void SaveCppExport(CppExport& cppexp, const char* filename)
 	{
 		relocator.AddPointers(schema_ptr, cppexp.db->enums[i].constants);
 		relocator.AddPointers(schema_ptr, cppexp.db->enums[i].attributes);
+		relocator.AddPointers(schema_ptr, cppexp.db->enums[i].constants_by_value);
+		relocator.AddPointers(schema_ptr, cppexp.db->enums[i].value_table);
+		relocator.AddPointers(schema_ptr, cppexp.db->enums[i].flag_constants);
 	}
 	for (unsigned int i = 0; i < cppexp.db->fields.size; i++)
 	{
@@ -1363,6 +1874,7 @@ void SaveCppExport(CppExport& cppexp, const char* filename)
 		relocator.AddPointers(schema_ptr, cls.fields);
 		relocator.AddPointers(schema_ptr, cls.attributes);
 		relocator.AddPointers(schema_ptr, cls.templates);
+		relocator.AddPointers(schema_ptr, cls.flattened_fields);
 	}
 	for (unsigned int i = 0; i < cppexp.db->templates.size; i++)
 	{
@@ -1390,16 +1902,6 @@ void SaveCppExport(CppExport& cppexp, const char* filename)
 		relocator.AddPointers(schema_ptr, cppexp.db->type_primitives[i]->base_types);
 	}
 
-	// Make all pointers relative to the start address
-	relocator.MakeRelative();
-
-	// Open the output file
-	FILE* fp = fopen(filename, "wb");
-	if (fp == 0)
-	{
-		return;
-	}
-
 	// Count the total number of pointer offsets
 	size_t nb_ptr_offsets = 0;
 	const std::vector<PtrSchema*>& schemas = relocator.GetSchemas();
@@ -1408,39 +1910,112 @@ void SaveCppExport(CppExport& cppexp, const char* filename)
 		nb_ptr_offsets += schemas[i]->ptr_offsets.size();
 	}
 
-	// Write the header
+	// The relocation data is written before the memory map so that the runtime can read it
+	// before deciding which sections to load
+	relocator.BuildLinks();
+	const std::vector<PtrLink>& links = relocator.GetLinks();
 	clcpp::internal::DatabaseFileHeader header;
+	#if defined(CLCPP_COMPACT_LAYOUT)
+		header.flags |= clcpp::internal::DATABASE_FLAG_COMPACT_LAYOUT;
+	#endif
 	header.nb_ptr_schemas = schemas.size();
 	header.nb_ptr_offsets = nb_ptr_offsets;
+	header.nb_ptr_relocations = relocator.GetRelocations().size();
+	header.nb_ptr_links = links.size();
+	size_t data_offset = sizeof(header) +
+		header.nb_ptr_schemas * sizeof(size_t) * 3 +
+		header.nb_ptr_offsets * sizeof(size_t) +
+		header.nb_ptr_relocations * sizeof(PtrRelocation) +
+		header.nb_ptr_links * sizeof(PtrLink);
+	header.data_offset = (data_offset + 15) & ~15;
+
+	// Make all pointers relative to the start of the memory map, prelinking them if an in-place
+	// load address has been specified. Compressed files can't be loaded in-place.
+	if (cppexp.load_address != 0 && !cppexp.compress)
+		header.data_base = cppexp.load_address + header.data_offset;
+	relocator.MakeRelative(header.data_base);
+
+	// Record where each section is and which relocation instructions patch it
 	const std::vector<PtrRelocation>& relocations = relocator.GetRelocations();
-	header.nb_ptr_relocations = relocations.size();
 	header.data_size = cppexp.allocator.GetAllocatedSize();
-	fwrite(&header, sizeof(header), 1, fp);
-
-	// Write the complete memory map
-	fwrite(cppexp.allocator.GetData(), cppexp.allocator.GetAllocatedSize(), 1, fp);
+	size_t first_relocation = 0;
+	for (int i = 0; i < clcpp::internal::NB_DATABASE_SECTIONS; i++)
+	{
+		clcpp::internal::DatabaseSection& section = header.sections[i];
+		section.data_offset = cppexp.allocator.GetSectionOffset(i);
+		section.data_size = cppexp.allocator.GetSectionSize(i);
+		section.first_ptr_relocation = first_relocation;
+		while (first_relocation < relocations.size() && relocations[first_relocation].offset < section.data_offset + section.data_size)
+			first_relocation++;
+		section.nb_ptr_relocations = first_relocation - section.first_ptr_relocation;
+	}
+	assert(first_relocation == relocations.size());
 
-	// Write the stride of each schema and the location of their pointers
+	// Gather the stride of each schema and the location of their pointers
+	std::vector<size_t> schema_data;
 	size_t ptrs_offset = 0;
 	for (size_t i = 0; i < schemas.size(); i++)
 	{
 		const PtrSchema& s = *schemas[i];
 		size_t nb_ptrs = s.ptr_offsets.size();
-		fwrite(&s.stride, sizeof(s.stride), 1, fp);
-		fwrite(&ptrs_offset, sizeof(ptrs_offset), 1, fp);
-		fwrite(&nb_ptrs, sizeof(nb_ptrs), 1, fp);
+		schema_data.push_back(s.stride);
+		schema_data.push_back(ptrs_offset);
+		schema_data.push_back(nb_ptrs);
 		ptrs_offset += nb_ptrs;
 	}
 
-	// Write the schema pointer offsets
+	// Follow with the schema pointer offsets, the relocations and links between sections
+	std::vector<char> tables;
+	AppendData(tables, schema_data);
 	for (size_t i = 0; i < schemas.size(); i++)
+		AppendData(tables, schemas[i]->ptr_offsets);
+	AppendData(tables, relocations);
+	AppendData(tables, links);
+	assert(sizeof(header) + tables.size() == data_offset);
+
+	// Lay out the complete memory map with all sections end-to-end
+	std::vector<char> data(header.data_size);
+	cppexp.allocator.CopyData(&data.front());
+
+	std::vector<char> output;
+	if (cppexp.compress)
+	{
+		// Compress the relocation data and each section separately so that sections can
+		// still be seeked to and loaded on demand
+		header.flags |= clcpp::internal::DATABASE_FLAG_COMPRESSED;
+		CompressBlocks(&tables.front(), tables.size(), output);
+		for (int i = 0; i < clcpp::internal::NB_DATABASE_SECTIONS; i++)
+		{
+			clcpp::internal::DatabaseSection& section = header.sections[i];
+			section.file_offset = sizeof(header) + output.size();
+			CompressBlocks(&data.front() + section.data_offset, section.data_size, output);
+			section.file_size = sizeof(header) + output.size() - section.file_offset;
+		}
+	}
+	else
 	{
-		const PtrSchema& s = *schemas[i];
-		fwrite(&s.ptr_offsets.front(), sizeof(size_t), s.ptr_offsets.size(), fp);
+		// Pad the memory map to its aligned offset, where it can be mapped in-place
+		output.swap(tables);
+		output.resize(header.data_offset - sizeof(header), 0);
+		output.insert(output.end(), data.begin(), data.end());
+		for (int i = 0; i < clcpp::internal::NB_DATABASE_SECTIONS; i++)
+		{
+			clcpp::internal::DatabaseSection& section = header.sections[i];
+			section.file_offset = header.data_offset + section.data_offset;
+			section.file_size = section.data_size;
+		}
+	}
+
+	// Open the output file
+	FILE* fp = fopen(filename, "wb");
+	if (fp == 0)
+	{
+		return;
 	}
 
-	// Write the relocations
-	fwrite(&relocations.front(), sizeof(PtrRelocation), relocations.size(), fp);
+	// Write the header, followed by everything else
+	fwrite(&header, sizeof(header), 1, fp);
+	fwrite(&output.front(), output.size(), 1, fp);
 
 	fclose(fp);
 }
@@ -13,6 +13,7 @@
 
 
 #include "StackAllocator.h"
+#include <clcpp/clcpp_internal.h>
 #include <map>
 #include <vector>
 
@@ -26,8 +27,10 @@ namespace cldb
 struct CppExport
 {
 	CppExport(clcpp::pointer_type function_base_address)
-		: allocator(5 * 1024 * 1024)	// 5MB should do for now
+		: allocator(5 * 1024 * 1024, clcpp::internal::NB_DATABASE_SECTIONS)	// 5MB per section should do for now
 		, function_base_address(function_base_address)
+		, load_address(0)
+		, compress(false)
 		, db(0)
 	{
 	}
@@ -35,6 +38,13 @@ struct CppExport
 	StackAllocator allocator;
 
 	clcpp::pointer_type function_base_address;
+
+	// If non-zero, the address the saved file is prelinked to be loaded in-place at
+	clcpp::pointer_type load_address;
+
+	// Compress the saved file, trading load time CPU for smaller files. These can't be loaded in-place.
+	bool compress;
+
 	clcpp::internal::DatabaseMem* db;
 
 	// Hash of names for easier debugging
@@ -17,6 +17,8 @@
 #include <clReflectCore/DatabaseTextSerialiser.h>
 #include <clReflectCore/DatabaseBinarySerialiser.h>
 
+#include <stdio.h>
+
 
 int main(int argc, const char* argv[])
 {
@@ -61,6 +63,26 @@ int main(int argc, const char* argv[])
 		if (!BuildCppExport(db, cppexp))
 			return 1;
 
+		// Optionally prelink the database for zero-copy loading at a fixed address
+		std::string cpp_base = args.GetProperty("-cpp_base");
+		if (cpp_base != "")
+		{
+			// Reject anything that isn't entirely a non-zero hex address, rather than silently
+			// exporting a database that can't be loaded in-place
+			char trailing;
+			if (sscanf(cpp_base.c_str(), "%" CLCPP_POINTER_TYPE_HEX_FORMAT "%c", &cppexp.load_address, &trailing) != 1 ||
+				cppexp.load_address == 0)
+			{
+				LOG(main, ERROR, "Invalid -cpp_base address '%s'; expected a non-zero hex address\n", cpp_base.c_str());
+				return 1;
+			}
+		}
+
+		// Optionally compress the database, which takes precedence over prelinking
+		cppexp.compress = args.Have("-cpp_compress");
+		if (cppexp.compress && cppexp.load_address != 0)
+			LOG(main, WARNING, "Compressed databases can't be loaded in-place; ignoring -cpp_base\n");
+
 		// Pretty-print the result to the specified output file
 		std::string cpp_log = args.GetProperty("-cpp_log");
 		if (cpp_log != "")
@@ -9,22 +9,22 @@
 //
 
 #include "PtrRelocator.h"
+#include "StackAllocator.h"
+#include <algorithm>
 #include <cassert>
 
 
 namespace
 {
-	template <typename TYPE_A, typename TYPE_B>
-	inline size_t distance(const TYPE_A* from, const TYPE_B* to)
+	bool SortRelocationByOffset(const PtrRelocation& a, const PtrRelocation& b)
 	{
-		return (size_t)((char*)to - (char*)from);
+		return a.offset < b.offset;
 	}
 }
 
 
-PtrRelocator::PtrRelocator(const void* start, size_t data_size)
-	: m_Start((char*)start)
-	, m_DataSize(data_size)
+PtrRelocator::PtrRelocator(const StackAllocator& allocator)
+	: m_Allocator(allocator)
 {
 }
 
@@ -51,19 +51,57 @@ PtrSchema& PtrRelocator::AddSchema(size_t stride, PtrSchema* base_schema)
 
 void PtrRelocator::AddPointers(const PtrSchema& schema, const void* data, int nb_objects)
 {
-	// No need to add null pointers for patching
-	if (data == 0)
+	// No need to add null pointers or empty arrays for patching
+	if (data == 0 || nb_objects == 0)
 		return;
 
 	PtrRelocation relocation;
 	relocation.schema_handle = schema.handle;
-	relocation.offset = distance(m_Start, data);
+	relocation.offset = m_Allocator.GetOffset(data);
 	relocation.nb_objects = nb_objects;
 	m_Relocations.push_back(relocation);
 }
 
 
-void PtrRelocator::MakeRelative()
+void PtrRelocator::BuildLinks()
+{
+	m_Links.clear();
+
+	for (size_t i = 0; i < m_Relocations.size(); i++)
+	{
+		PtrRelocation& reloc = m_Relocations[i];
+		PtrSchema& schema = *m_SchemaLookup[reloc.schema_handle];
+
+		for (int j = 0; j < reloc.nb_objects; j++)
+		{
+			size_t object_offset = reloc.offset + j * schema.stride;
+
+			for (size_t k = 0; k < schema.ptr_offsets.size(); k++)
+			{
+				unsigned int ptr_offset = object_offset + schema.ptr_offsets[k];
+				char* ptr = *(char**)m_Allocator.GetAddress(ptr_offset);
+
+				// Pointers into sections other than the first can't be relied upon to be
+				// loaded before the pointer itself is relocated
+				if (ptr != 0)
+				{
+					int ptr_section = m_Allocator.GetSection(m_Allocator.GetAddress(ptr_offset));
+					int target_section = m_Allocator.GetSection(ptr);
+					if (target_section != 0 && target_section != ptr_section)
+					{
+						PtrLink link;
+						link.ptr_offset = ptr_offset;
+						link.target_offset = m_Allocator.GetOffset(ptr);
+						m_Links.push_back(link);
+					}
+				}
+			}
+		}
+	}
+}
+
+
+void PtrRelocator::MakeRelative(clcpp::pointer_type base_address)
 {
 	// Process each relocation instruction
 	for (size_t i = 0; i < m_Relocations.size(); i++)
@@ -80,16 +118,18 @@ void PtrRelocator::MakeRelative()
 			for (size_t k = 0; k < schema.ptr_offsets.size(); k++)
 			{
 				unsigned int ptr_offset = object_offset + schema.ptr_offsets[k];
-				char*& ptr = (char*&)*(m_Start + ptr_offset);
+				char*& ptr = (char*&)*m_Allocator.GetAddress(ptr_offset);
 
 				// Only relocate if it's non-null
 				if (ptr != 0)
 				{
-					size_t d = distance(m_Start, ptr);
-					assert(d <= m_DataSize);
-					ptr = (char*)d;
+					size_t d = m_Allocator.GetOffset(ptr);
+					ptr = (char*)(base_address + d);
 				}
 			}
 		}
 	}
+
+	// Group the relocation instructions by the section they patch
+	std::sort(m_Relocations.begin(), m_Relocations.end(), SortRelocationByOffset);
 }
\ No newline at end of file
@@ -18,6 +18,9 @@
 #include <clReflectCore/Array.h>
 
 
+class StackAllocator;
+
+
 //
 // Schema that describes the location of pointers within a type
 //
@@ -76,6 +79,21 @@ struct PtrRelocation
 };
 
 
+//
+// A pointer from any section of the memory map, including the first, into a different section
+// that may be loaded after it. The runtime leaves the pointer null until that section arrives
+// and uses the link to patch it then.
+//
+struct PtrLink
+{
+	// Location of the pointer in the memory map
+	size_t ptr_offset;
+
+	// Offset in the memory map that the pointer points to
+	size_t target_offset;
+};
+
+
 //
 // Class for building pointer schemas, relocation instructions and applying transformations
 // to the pointers.
@@ -83,7 +101,7 @@ struct PtrRelocation
 class PtrRelocator
 {
 public:
-	PtrRelocator(const void* start, size_t data_size);
+	PtrRelocator(const StackAllocator& allocator);
 
 	// Add a new schema which doesn't have any pointer offsets beyond those it inherits
 	PtrSchema& AddSchema(size_t stride, PtrSchema* base_schema);
@@ -106,20 +124,29 @@ public:
 		AddPointers(schema, array.data, array.size);
 	}
 
-	// Make all pointers relative to the start memory address
-	void MakeRelative();
+	// Generate links for any pointers that cross from one section of the allocator to another,
+	// other than those pointing into the first section, which is always loaded. This must be
+	// called before the pointers are made relative.
+	void BuildLinks();
+
+	// Make all pointers relative to the start of the allocator's flattened memory layout, with an
+	// optional base address added to all non-null pointers to prelink them for loading at that
+	// address. Relocation instructions are sorted by offset so that they're grouped by the
+	// section they patch.
+	void MakeRelative(clcpp::pointer_type base_address = 0);
 
 	const std::vector<PtrSchema*>& GetSchemas() const { return m_SchemaLookup; }
 	const std::vector<PtrRelocation>& GetRelocations() const { return m_Relocations; }
+	const std::vector<PtrLink>& GetLinks() const { return m_Links; }
 
 private:
-	// This is the front of the allocated memory where all pointers will be made relative to
-	char* m_Start;
-	size_t m_DataSize;
+	// All pointers are made relative to the flattened memory of this allocator
+	const StackAllocator& m_Allocator;
 
 	// Stored as a list so that I can return pointers after each addition
 	std::list<PtrSchema> m_Schemas;
 	std::vector<PtrSchema*> m_SchemaLookup;
 
 	std::vector<PtrRelocation> m_Relocations;
+	std::vector<PtrLink> m_Links;
 };
@@ -12,6 +12,8 @@
 
 
 #include <cassert>
+#include <cstring>
+#include <vector>
 #include <clReflectCore/Array.h>
 
 
@@ -43,23 +45,46 @@ template <> inline bool is_builtin<clcpp::uint64>() { return true; }
 // contiguous set of pages which are committed on demand. Before that, though: the
 // database really shouldn't be any bigger than a couple of megabytes!
 //
+// Allocations can be directed to any number of sections, each with their own stack.
+// When the allocated data is saved, the sections are laid out end-to-end in order.
+// Offsets returned by this class are relative to the start of that flattened layout.
+//
 class StackAllocator
 {
 public:
-	StackAllocator(int size)
-		: m_Data(new char[size])
-		, m_Size(size)
-		, m_Offset(0)
+	StackAllocator(int size, int nb_sections = 1)
+		: m_Sections(nb_sections)
+		, m_CurrentSection(0)
+	{
+		for (int i = 0; i < nb_sections; i++)
+		{
+			m_Sections[i].data = new char[size];
+			m_Sections[i].size = size;
+			m_Sections[i].offset = 0;
+		}
+	}
+
+	~StackAllocator()
 	{
+		for (size_t i = 0; i < m_Sections.size(); i++)
+			delete [] m_Sections[i].data;
+	}
+
+	// Direct all subsequent allocations to the given section
+	void SetSection(int section)
+	{
+		assert(section >= 0 && section < (int)m_Sections.size());
+		m_CurrentSection = section;
 	}
 
 	template <typename TYPE>
 	TYPE* Alloc(unsigned int count)
 	{
 		// Allocate the required amount of bytes
-		TYPE* data = (TYPE*)(m_Data + m_Offset);
-		m_Offset += count * sizeof(TYPE);
-		assert(m_Offset <= m_Size && "Stack allocator overflowed");
+		Section& section = m_Sections[m_CurrentSection];
+		TYPE* data = (TYPE*)(section.data + section.offset);
+		section.offset += count * sizeof(TYPE);
+		assert(section.offset <= section.size && "Stack allocator overflowed");
 
 		// Default construct non-builtin types
 		if (!is_builtin<TYPE>())
@@ -82,14 +107,94 @@ public:
 		shallow_copy(array, temp_array);
 	}
 
-	const void* GetData() const { return m_Data; }
-	unsigned int GetSize() const { return m_Size; }
-	unsigned int GetAllocatedSize() const { return m_Offset; }
+#if defined(CLCPP_COMPACT_LAYOUT)
+	template <typename TYPE>
+	void Alloc(clcpp::PrimitiveArray<TYPE>& array, int size)
+	{
+		// The compact layout expects the name hashes directly after the primitive pointers
+		Alloc((clcpp::CArray<const TYPE*>&)array, size);
+		Alloc<unsigned int>(size);
+	}
+#endif
+
+	int GetNbSections() const { return (int)m_Sections.size(); }
+
+	// Sections are padded so that each one starts with the same alignment as the first
+	unsigned int GetSectionSize(int section) const
+	{
+		return (m_Sections[section].offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+	}
+
+	unsigned int GetSectionOffset(int section) const
+	{
+		unsigned int offset = 0;
+		for (int i = 0; i < section; i++)
+			offset += GetSectionSize(i);
+		return offset;
+	}
+
+	unsigned int GetAllocatedSize() const
+	{
+		return GetSectionOffset(m_Sections.size());
+	}
+
+	// Returns the section an allocated address belongs to, or -1 if it's not from this allocator.
+	// The end of a section's allocated data is considered part of that section.
+	int GetSection(const void* ptr) const
+	{
+		for (size_t i = 0; i < m_Sections.size(); i++)
+		{
+			const Section& section = m_Sections[i];
+			if (ptr >= section.data && ptr <= section.data + section.offset)
+				return (int)i;
+		}
+		return -1;
+	}
+
+	// Mapping between allocated addresses and their offset in the flattened layout
+	unsigned int GetOffset(const void* ptr) const
+	{
+		int section = GetSection(ptr);
+		assert(section != -1 && "Pointer not allocated by the stack allocator");
+		return GetSectionOffset(section) + (unsigned int)((const char*)ptr - m_Sections[section].data);
+	}
+	char* GetAddress(unsigned int offset) const
+	{
+		for (size_t i = 0; i < m_Sections.size(); i++)
+		{
+			unsigned int size = GetSectionSize(i);
+			if (offset < size)
+				return m_Sections[i].data + offset;
+			offset -= size;
+		}
+		assert(false && "Offset outside of the stack allocator");
+		return 0;
+	}
+
+	// Copy the flattened layout of all sections, including zeroed padding
+	void CopyData(void* dest) const
+	{
+		char* pos = (char*)dest;
+		for (size_t i = 0; i < m_Sections.size(); i++)
+		{
+			const Section& section = m_Sections[i];
+			unsigned int size = GetSectionSize(i);
+			memcpy(pos, section.data, section.offset);
+			memset(pos + section.offset, 0, size - section.offset);
+			pos += size;
+		}
+	}
 
 private:
-	char* m_Data;
-	unsigned int m_Size;
-	unsigned int m_Offset;
-};
+	static const unsigned int SECTION_ALIGNMENT = 16;
 
+	struct Section
+	{
+		char* data;
+		unsigned int size;
+		unsigned int offset;
+	};
 
+	std::vector<Section> m_Sections;
+	int m_CurrentSection;
+};
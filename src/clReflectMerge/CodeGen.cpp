@@ -377,6 +377,19 @@ namespace
 			{
 				std::string name = NameWithGlobalScope(prim);
 				cg.Line("template <> const Type* GetType< %s >() { return clcppTypePtrs[%d]; }", name.c_str(), i);
+			}
+		}
+	}
+
+
+	void GenGetTypeNameHashes(CodeGen& cg, const std::vector<Primitive>& primitives, unsigned int prim_types)
+	{
+		for (size_t i = 0; i < primitives.size(); i++)
+		{
+			const Primitive& prim = primitives[i];
+			if ((prim.type & prim_types) != 0)
+			{
+				std::string name = NameWithGlobalScope(prim);
 				cg.Line("template <> unsigned int GetTypeNameHash< %s >() { return clcppTypeNameHashes[%d]; }", name.c_str(), i);
 			}
 		}
@@ -435,6 +448,14 @@ void GenMergedCppImpl(const char* filename, const cldb::Database& db)
 	cg.Line("#if defined(CLCPP_USING_MSVC)");
 	GenGetTypes(cg, primitives, PT_Enum);
 	cg.Line("#endif");
+
+	// The compiler can provide GetTypeNameHash itself
+	cg.Line("#if !defined(CLCPP_COMPILER_TYPE_NAMES)");
+	GenGetTypeNameHashes(cg, primitives, PT_Type | PT_Class | PT_Struct);
+	cg.Line("#if defined(CLCPP_USING_MSVC)");
+	GenGetTypeNameHashes(cg, primitives, PT_Enum);
+	cg.Line("#endif");
+	cg.Line("#endif");
 	cg.ExitScope();
 
 	// Generate the hash for the generated code so far
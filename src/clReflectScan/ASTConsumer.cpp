@@ -490,9 +490,9 @@ namespace
 
 		// Look for a reflection spec as the first attribute
 		size_t attr_search_start = 0;
-		static unsigned int reflect_hash = clcpp::internal::HashNameString("reflect");
-		static unsigned int reflect_part_hash = clcpp::internal::HashNameString("reflect_part");
-		static unsigned int noreflect_hash = clcpp::internal::HashNameString("noreflect");
+		static const unsigned int reflect_hash = CLCPP_NAME_HASH("reflect");
+		static const unsigned int reflect_part_hash = CLCPP_NAME_HASH("reflect_part");
+		static const unsigned int noreflect_hash = CLCPP_NAME_HASH("noreflect");
 		if (attributes.size())
 		{
 			unsigned int name_hash = attributes[0]->name.hash;
@@ -11,11 +11,17 @@
 #include <clcpp/clcpp.h>
 
 #include <cstdio>
+#include <cstring>
 #if defined(CLCPP_USING_MSVC)
 #include <malloc.h>
 #else
 #include <stdlib.h>
 #endif
+#if defined(CLCPP_PLATFORM_WINDOWS)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
 #include <stdarg.h>
 #include <errno.h>
 
@@ -50,6 +56,20 @@ public:
 		return fread(dest, 1, size, m_FP) == size;
 	}
 
+	bool Seek(clcpp::size_type offset)
+	{
+		return fseek(m_FP, offset, SEEK_SET) == 0;
+	}
+
+	clcpp::size_type GetSize()
+	{
+		long position = ftell(m_FP);
+		fseek(m_FP, 0, SEEK_END);
+		long size = ftell(m_FP);
+		fseek(m_FP, position, SEEK_SET);
+		return size;
+	}
+
 private:
 	FILE* m_FP;
 };
@@ -77,10 +97,92 @@ extern void TestSerialiseJSON(clcpp::Database& db);
 extern void TestOffsets(clcpp::Database& db);
 extern void TestTypedefsFunc(clcpp::Database& db);
 extern void TestFunctionSerialise(clcpp::Database& db);
+extern void TestCollectionsFunc(clcpp::Database& db);
+extern void TestTypesSection(clcpp::Database& db, clcpp::Database& types_db);
 
 extern void clcppInitGetType(const clcpp::Database* db);
 
 
+static void* AllocAtAddress(clcpp::pointer_type address, clcpp::size_type size)
+{
+#if defined(CLCPP_PLATFORM_WINDOWS)
+	return VirtualAlloc((void*)address, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+	// Without MAP_FIXED the address is only a hint, so check it was honoured
+	void* data = mmap((void*)address, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (data == MAP_FAILED)
+		return 0;
+	if (data != (void*)address)
+	{
+		munmap(data, size);
+		return 0;
+	}
+	return data;
+#endif
+}
+
+
+static void FreeAtAddress(void* data, clcpp::size_type size)
+{
+#if defined(CLCPP_PLATFORM_WINDOWS)
+	VirtualFree(data, 0, MEM_RELEASE);
+#else
+	munmap(data, size);
+#endif
+}
+
+
+static bool TestLoadInPlace(clcpp::Database& db)
+{
+	// This copy of the database is exported prelinked at a fixed address (clexport -cpp_base)
+	StdFile file("clReflectTestInPlace.cppbin");
+	if (!file.IsOpen())
+		return false;
+	clcpp::pointer_type address = clcpp::Database::GetInPlaceLoadAddress(&file);
+	clcpp::size_type size = file.GetSize();
+	if (address == 0)
+		return false;
+
+	// Copy the file to the address it was prelinked against
+	void* data = AllocAtAddress(address, size);
+	if (data == 0)
+		return false;
+	bool read = file.Seek(0) && file.Read(data, size);
+
+	{
+		clcpp::Database inplace_db;
+		clcpp::internal::Assert(read && inplace_db.LoadInPlace(data, size, 0));
+
+		// Types are returned from the file data without relocation
+		unsigned int hash = db.GetName("ClassGlobalA").hash;
+		const clcpp::Type* type = inplace_db.GetType(hash);
+		clcpp::internal::Assert(type != 0 && (clcpp::pointer_type)type > address && (clcpp::pointer_type)type < address + size);
+		clcpp::internal::Assert(type->name.hash == hash && strcmp(type->name.text, "ClassGlobalA") == 0);
+		clcpp::internal::Assert(type->size == db.GetType(hash)->size);
+	}
+
+	FreeAtAddress(data, size);
+	return true;
+}
+
+
+static bool TestLoadTypesSection(clcpp::Database& db)
+{
+	// The file has to outlive the database while any sections are deferred
+	StdFile file("clReflectTest.cppbin");
+	if (!file.IsOpen())
+		return false;
+
+	Malloc allocator;
+	clcpp::Database types_db;
+	if (!types_db.Load(&file, &allocator, clcpp::Database::GetModuleLoadAddress(), 0, clcpp::Database::SECTION_TYPES))
+		return false;
+
+	TestTypesSection(db, types_db);
+	return true;
+}
+
+
 
 int main()
 {
@@ -105,6 +207,12 @@ int main()
 	TestSerialiseJSON(db);
 	TestTypedefsFunc(db);
 	TestFunctionSerialise(db);
+	TestCollectionsFunc(db);
+
+	if (!TestLoadInPlace(db))
+		return 1;
+	if (!TestLoadTypesSection(db))
+		return 1;
 
 	return 0;
 }
\ No newline at end of file
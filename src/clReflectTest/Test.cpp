@@ -600,5 +600,12 @@ void TestGetType(clcpp::Database& db)
 	printf("%x\n", clcpp::GetTypeNameHash<char>());
 	printf("%x\n", clcpp::GetTypeNameHash<ClassGlobalA>());
 	printf("%x\n", clcpp::GetTypeNameHash<Inheritance::DerivedClass>());
+
+	// Constant-time subtype checks, including multiple inheritance
+	const clcpp::Type* base = clcpp::GetType<Inheritance::BaseClass>();
+	const clcpp::Type* error = clcpp::GetType<Inheritance::ErrorClass>();
+	const clcpp::Type* multiple = clcpp::GetType<Inheritance::MultipleInheritanceClass>();
+	clcpp::internal::Assert(e1->IsA(base) && e1->IsA(e1) && !base->IsA(e1));
+	clcpp::internal::Assert(multiple->IsA(base) && multiple->IsA(error) && !e1->IsA(error));
 }
 
@@ -50,6 +50,10 @@ void TestConstructorDestructor(clcpp::Database& db)
 	const clcpp::Class* ca = clcpp::GetType<TestClassImpl::A>()->AsClass();
 	const clcpp::Class* cb = clcpp::GetType<TestClassImpl::B>()->AsClass();
 
+	// The exporter must resolve these in both the default and compact layouts
+	clcpp::internal::Assert(ca->constructor != 0 && ca->destructor != 0);
+	clcpp::internal::Assert(cb->constructor != 0 && cb->destructor != 0);
+
 	TestClassImpl::A* a = (TestClassImpl::A*)new char[sizeof(TestClassImpl::A)];
 	TestClassImpl::B* b = (TestClassImpl::B*)new char[sizeof(TestClassImpl::B)];
 
@@ -9,17 +9,66 @@
 //
 
 #include <clcpp/clcpp.h>
-#include <vector>
-#include <map>
+#include <clcpp/StdContainers.h>
+#include <clutl/Serialise.h>
 
 
 clcpp_reflect(TestCollections)
 namespace TestCollections
 {
+	typedef std::map<int, float> IntFloatMap;
+
 	struct Struct
 	{
-		//std::vector<int> x;
+		std::vector<int> x;
+		IntFloatMap m;
 	};
 }
 
+
+clcpp_std_vector_iterators(IntVector, std::vector<int>, "std::vector<int,std::allocator<int>>")
+clcpp_std_map_iterators(IntFloatMap, TestCollections::IntFloatMap, "std::map<int,float,std::less<int>,std::allocator<std::pair<const int,float>>>")
+
 clcpp_reflect(std::vector)
+clcpp_reflect(std::map)
+
+
+void TestCollectionsFunc(clcpp::Database& db)
+{
+	std::vector<int> values;
+	for (int i = 0; i < 100; i++)
+		values.push_back(i * 3);
+
+	// Write a vector in bulk, reserving storage for the count up-front
+	const clcpp::TemplateType* vector_type = db.GetType(db.GetName("std::vector<int,std::allocator<int>>").hash)->AsTemplateType();
+	std::vector<int> written;
+	clcpp::WriteIterator writer;
+	writer.Initialise(vector_type, &written, (int)values.size());
+	clcpp::internal::Assert(written.capacity() >= values.size());
+	int* write_data = (int*)writer.AddEmptyContiguous((unsigned int)values.size());
+	clcpp::internal::Assert(write_data == &written[0] && written.size() == values.size());
+	for (unsigned int i = 0; i < values.size(); i++)
+		write_data[i] = values[i];
+
+	// Read it back as a single contiguous run
+	clcpp::ReadIterator reader(vector_type, &written);
+	const void* read_data;
+	unsigned int count;
+	clcpp::internal::Assert(reader.GetContiguous(read_data, count) && read_data == &written[0] && count == reader.m_Count);
+	clcpp::internal::Assert(written == values);
+
+	// Round-trip both containers through JSON, with the map saving its keys
+	TestCollections::Struct src;
+	src.x = values;
+	for (int i = 0; i < 10; i++)
+		src.m[i * 7 - 20] = i * 0.5f;
+	const clcpp::Type* type = clcpp::GetType<TestCollections::Struct>();
+	clutl::WriteBuffer write_buffer;
+	clutl::SaveJSON(write_buffer, &src, type, 0);
+	clutl::ReadBuffer read_buffer(write_buffer);
+	TestCollections::Struct dest;
+	dest.m[1000] = 1;
+	clutl::JSONError error = clutl::LoadJSON(read_buffer, &dest, type);
+	clcpp::internal::Assert(error.code == clutl::JSONError::NONE);
+	clcpp::internal::Assert(dest.x == src.x && dest.m == src.m);
+}
@@ -0,0 +1,71 @@
+//
+// ===============================================================================
+// clReflect
+// -------------------------------------------------------------------------------
+// Copyright (c) 2011-2012 Don Williamson & clReflect Authors (see AUTHORS file)
+// Released under MIT License (see LICENSE file)
+// ===============================================================================
+//
+
+#include <clcpp/clcpp.h>
+#include <clutl/Objects.h>
+#include <clutl/Serialise.h>
+
+
+clcpp_reflect(TestSections)
+namespace TestSections
+{
+	// Custom vbin hooks that double the value so that the round trip shows they were called
+	void SaveDoubled(clutl::WriteBuffer& out, const int* value)
+	{
+		int doubled = *value * 2;
+		out.Write(&doubled, sizeof(doubled));
+	}
+	void LoadDoubled(clutl::ReadBuffer& in, int* value)
+	{
+		in.Read(value, sizeof(*value));
+	}
+
+
+	struct Hooked
+	{
+		Hooked() : value(0) { }
+
+		clcpp_attr(save_vbin = TestSections::SaveDoubled, load_vbin = TestSections::LoadDoubled)
+		int value;
+	};
+
+
+	struct CreatedObject : public clobj::Object
+	{
+		int x;
+	};
+}
+
+clcpp_impl_class(TestSections::CreatedObject)
+
+
+void TestTypesSection(clcpp::Database& db, clcpp::Database& types_db)
+{
+	// Classes point into the functions and attributes so they have to be loaded with the types
+	unsigned int loaded = clcpp::Database::SECTION_TYPES | clcpp::Database::SECTION_FUNCTIONS | clcpp::Database::SECTION_ATTRIBUTES;
+	clcpp::internal::Assert((types_db.GetLoadedSections() & loaded) == loaded);
+
+	// Custom field hooks are found through the field attributes
+	const clcpp::Type* hooked_type = types_db.GetType(db.GetName("TestSections::Hooked").hash);
+	clcpp::internal::Assert(hooked_type != 0);
+	TestSections::Hooked hooked;
+	hooked.value = 21;
+	clutl::WriteBuffer out;
+	clutl::SaveVersionedBinary(out, &hooked, hooked_type);
+	TestSections::Hooked loaded_hooked;
+	clutl::ReadBuffer in(out);
+	clutl::LoadVersionedBinary(in, &loaded_hooked, hooked_type);
+	clcpp::internal::Assert(loaded_hooked.value == 42);
+
+	// Objects are created with the class constructor
+	const clcpp::Type* object_type = types_db.GetType(db.GetName("TestSections::CreatedObject").hash);
+	clobj::Object* object = clobj::CreateObject(object_type);
+	clcpp::internal::Assert(object != 0 && object->type == object_type);
+	clobj::DestroyObject(object);
+}
\ No newline at end of file
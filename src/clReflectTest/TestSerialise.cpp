@@ -65,12 +65,68 @@ namespace Stuff
 		SomeEnum e;
 		NestedStruct n;
 	};
+
+
+	struct Node
+	{
+		Node()
+			: value(0), next(0), other(0)
+		{
+		}
+		int value;
+		Node* next;
+		Node* other;
+	};
 };
 
 
 #include <stdio.h>
 
 
+namespace
+{
+	struct SaveAllPtrs : public clutl::IPtrSave
+	{
+		bool CanSavePtr(void* ptr, const clcpp::Field* field, const clcpp::Type* type)
+		{
+			return true;
+		}
+		unsigned int SavePtr(void* ptr)
+		{
+			return 0;
+		}
+	};
+
+
+	struct NodeLoader : public clutl::IPtrLoad
+	{
+		NodeLoader(clcpp::Database& db)
+			: db(db)
+		{
+		}
+		const clcpp::Type* GetPtrType(unsigned int type_hash)
+		{
+			return db.GetType(type_hash);
+		}
+		void* CreatePtr(const clcpp::Type* type)
+		{
+			return new Stuff::Node;
+		}
+		clcpp::Database& db;
+	};
+
+
+	struct BufferSink : public clutl::IStreamSink
+	{
+		void Write(const void* data, unsigned int length)
+		{
+			buffer.Write(data, length);
+		}
+		clutl::WriteBuffer buffer;
+	};
+}
+
+
 void TestSerialise(clcpp::Database& db)
 {
 	clutl::WriteBuffer write_buffer;
@@ -80,4 +136,120 @@ void TestSerialise(clcpp::Database& db)
 	clutl::ReadBuffer read_buffer(write_buffer);
 	Stuff::DerivedStruct dest(Stuff::NO_INIT);
 	clutl::LoadVersionedBinary(read_buffer, &dest, clcpp::GetType<Stuff::DerivedStruct>());
+
+	// Load the same data from external memory
+	clutl::ReadBuffer external_read_buffer(write_buffer.GetData(), write_buffer.GetBytesWritten());
+	Stuff::DerivedStruct external_dest(Stuff::NO_INIT);
+	clutl::LoadVersionedBinary(external_read_buffer, &external_dest, clcpp::GetType<Stuff::DerivedStruct>());
+	clcpp::internal::Assert(external_read_buffer.GetBytesRemaining() == 0 && external_dest.x == dest.x);
+
+	// Reuse the compiled class plans for a sequence of objects
+	clutl::VBinPlanCache plan_cache;
+	clutl::WriteBuffer sequence_write_buffer;
+	src.x = 10;
+	clutl::SaveVersionedBinary(sequence_write_buffer, &src, clcpp::GetType<Stuff::DerivedStruct>(), 0, &plan_cache);
+	src.x = 20;
+	clutl::SaveVersionedBinary(sequence_write_buffer, &src, clcpp::GetType<Stuff::DerivedStruct>(), 0, &plan_cache);
+	clutl::ReadBuffer sequence_read_buffer(sequence_write_buffer);
+	Stuff::DerivedStruct sequence_dest[2] = { Stuff::DerivedStruct(Stuff::NO_INIT), Stuff::DerivedStruct(Stuff::NO_INIT) };
+	clutl::LoadVersionedBinary(sequence_read_buffer, &sequence_dest[0], clcpp::GetType<Stuff::DerivedStruct>(), 0, &plan_cache);
+	clutl::LoadVersionedBinary(sequence_read_buffer, &sequence_dest[1], clcpp::GetType<Stuff::DerivedStruct>(), 0, &plan_cache);
+	clcpp::internal::Assert(sequence_dest[0].x == 10 && sequence_dest[1].x == 20 && sequence_dest[1].n.i == 9);
+
+	// Snapshots copy the memory of classes like this, including their bases
+	clutl::WriteBuffer snapshot_write_buffer;
+	clutl::SaveSnapshot(snapshot_write_buffer, &src, clcpp::GetType<Stuff::DerivedStruct>());
+	clutl::ReadBuffer snapshot_read_buffer(snapshot_write_buffer);
+	Stuff::DerivedStruct snapshot_dest(Stuff::NO_INIT);
+	clutl::LoadSnapshot(snapshot_read_buffer, &snapshot_dest, clcpp::GetType<Stuff::DerivedStruct>());
+	clcpp::internal::Assert(snapshot_dest.x == 20 && snapshot_dest.be == Stuff::VAL_C && snapshot_dest.e == Stuff::VAL_B && snapshot_dest.n.g == 7);
+
+	// Save a cycle of nodes that's pointed to twice from the first node
+	Stuff::Node a, b;
+	a.value = 1;
+	a.next = &b;
+	a.other = &b;
+	b.value = 2;
+	b.next = &a;
+	const clcpp::Type* node_type = db.GetType(db.GetName("Stuff::Node").hash);
+	clutl::WriteBuffer graph_write_buffer;
+	SaveAllPtrs ptr_save;
+	clutl::SaveVersionedBinary(graph_write_buffer, &a, node_type, &ptr_save);
+
+	// The second node should only be loaded once, pointing back at the first
+	clutl::ReadBuffer graph_read_buffer(graph_write_buffer);
+	Stuff::Node loaded;
+	NodeLoader ptr_load(db);
+	clutl::LoadVersionedBinary(graph_read_buffer, &loaded, node_type, &ptr_load);
+	clcpp::internal::Assert(loaded.next != 0 && loaded.next == loaded.other);
+	clcpp::internal::Assert(loaded.next->value == 2 && loaded.next->next == &loaded && loaded.next->other == 0);
+	delete loaded.next;
+
+	// The same graph in the compact encoding, which is detected when loading
+	clutl::WriteBuffer compact_write_buffer;
+	clutl::SaveVersionedBinary(compact_write_buffer, &a, node_type, &ptr_save, 0, clutl::VBinFlags::COMPACT);
+	clutl::ReadBuffer compact_read_buffer(compact_write_buffer);
+	Stuff::Node compact_loaded;
+	clutl::LoadVersionedBinary(compact_read_buffer, &compact_loaded, node_type, &ptr_load);
+	clcpp::internal::Assert(compact_read_buffer.GetBytesRemaining() == 0 && compact_write_buffer.GetBytesWritten() < graph_write_buffer.GetBytesWritten());
+	clcpp::internal::Assert(compact_loaded.next != 0 && compact_loaded.next == compact_loaded.other && compact_loaded.next->next == &compact_loaded);
+	delete compact_loaded.next;
+
+	// Buffers growing within reserved memory never move what's already been written
+	clutl::WriteBuffer reserved_write_buffer(16, 1024 * 1024);
+	unsigned int* first_value = (unsigned int*)reserved_write_buffer.Alloc(sizeof(unsigned int));
+	*first_value = 0x1234;
+	for (int i = 0; i < 100; i++)
+		clutl::SaveVersionedBinary(reserved_write_buffer, &src, clcpp::GetType<Stuff::DerivedStruct>(), 0, &plan_cache);
+	clcpp::internal::Assert((const char*)first_value == reserved_write_buffer.GetData() && *first_value == 0x1234);
+	clcpp::internal::Assert(reserved_write_buffer.GetBytesAllocated() >= reserved_write_buffer.GetBytesWritten());
+
+	// Streaming through a small buffer should flush exactly what would have been written
+	BufferSink sink;
+	clutl::WriteBuffer stream_write_buffer(&sink, 64);
+	stream_write_buffer.Write(first_value, sizeof(unsigned int));
+	for (int i = 0; i < 100; i++)
+		clutl::SaveVersionedBinary(stream_write_buffer, &src, clcpp::GetType<Stuff::DerivedStruct>(), 0, &plan_cache);
+	stream_write_buffer.Flush();
+	clcpp::internal::Assert(stream_write_buffer.GetBytesFlushed() == reserved_write_buffer.GetBytesWritten());
+	clcpp::internal::Assert(sink.buffer.GetBytesWritten() == reserved_write_buffer.GetBytesWritten());
+	for (unsigned int i = 0; i < sink.buffer.GetBytesWritten(); i++)
+		clcpp::internal::Assert(sink.buffer.GetData()[i] == reserved_write_buffer.GetData()[i]);
+
+	// A large graph saved as frames should reach the sink while it's being saved, without the
+	// buffer growing beyond its chunk size
+	const int nb_chain_nodes = 4000;
+	Stuff::Node* chain = new Stuff::Node[nb_chain_nodes];
+	for (int i = 0; i < nb_chain_nodes; i++)
+	{
+		chain[i].value = i;
+		chain[i].next = i + 1 < nb_chain_nodes ? &chain[i + 1] : 0;
+		chain[i].other = &chain[(i * 7) % nb_chain_nodes];
+	}
+	BufferSink chain_sink;
+	clutl::WriteBuffer chain_write_buffer(&chain_sink, 4096);
+	clutl::SaveVersionedBinary(chain_write_buffer, chain, node_type, &ptr_save, 0, clutl::VBinFlags::STREAMED);
+	clcpp::internal::Assert(chain_sink.buffer.GetBytesWritten() > chain_write_buffer.GetBytesWritten() / 2);
+	clcpp::internal::Assert(chain_write_buffer.GetBytesAllocated() == 4096);
+	chain_write_buffer.Flush();
+
+	// Load it back from the sink, checking every link
+	clutl::ReadBuffer chain_read_buffer(chain_sink.buffer);
+	Stuff::Node chain_loaded;
+	clutl::LoadVersionedBinary(chain_read_buffer, &chain_loaded, node_type, &ptr_load);
+	clcpp::internal::Assert(chain_read_buffer.GetBytesRemaining() == 0);
+	Stuff::Node** chain_nodes = new Stuff::Node*[nb_chain_nodes];
+	Stuff::Node* node = &chain_loaded;
+	for (int i = 0; i < nb_chain_nodes; i++)
+	{
+		clcpp::internal::Assert(node != 0 && node->value == i);
+		chain_nodes[i] = node;
+		node = node->next;
+	}
+	for (int i = 0; i < nb_chain_nodes; i++)
+		clcpp::internal::Assert(chain_nodes[i]->other == chain_nodes[(i * 7) % nb_chain_nodes]);
+	for (int i = 1; i < nb_chain_nodes; i++)
+		delete chain_nodes[i];
+	delete [] chain_nodes;
+	delete [] chain;
 }
@@ -378,6 +378,8 @@ void TestSerialiseJSON(clcpp::Database& db)
 	Test("NegDecimalE11", "{ \"decimal\" : -123.123E-4 }");
 
 	Test("EscapeSequences", "{ \"string\" : \" \\\" \\\\ \\/ \\b \\f \\n \\r \\t \\u0123 \" }");
+	Test("EscapeSurrogates", "{ \"string\" : \"\\ud83d\\ude00 \\ud800 \\udc00\" }");
+	Test("EscapedName", "{ \"str\\u0069ng\" : \"val\" }");
 
 	Test("True", "{ \"value\" : true }");
 	Test("False", "{ \"value\" : false }");
@@ -389,6 +391,7 @@ void TestSerialiseJSON(clcpp::Database& db)
 	Test("StringErrorHexOverflow", "{ \"string\" : \"\\u1");
 	Test("StringErrorHexInvalid", "{ \"string\" : \"\\ug000\"");
 	Test("StringErrorInvalidEscape", "{ \"string\" : \"\\y\"");
+	Test("StringErrorSurrogateOverflow", "{ \"string\" : \"\\ud83d\\ude00");
 
 	Test("IntegerErrorSignOverflow", "{ \"integer\" : -");
 	Test("IntegerErrorNegOverflow", "{ \"integer\" : -123");
@@ -412,6 +415,9 @@ void TestSerialiseJSON(clcpp::Database& db)
 	Test("ErrorFalseInvalidKeyword", "{ \"value\" : fal ");
 	Test("ErrorNullInvalidKeyword", "{ \"value\" : nu ");
 
+	Test("LongString", "{ \"string\" : \"a string long enough to span more than one of the 64 character blocks \\\" that the lexer indexes\" }");
+	Test("ErrorLineColumn", "{\n\t\"string\" : \"val\",\r\n\n\t\"value\" :   x }");
+
 	clutl::WriteBuffer write_buffer;
 	jsontest::AllFields a;
 	clutl::SaveJSON(write_buffer, &a, clcpp::GetType<jsontest::AllFields>(), 0, clutl::JSONFlags::EMIT_HEX_FLOATS);
@@ -423,4 +429,18 @@ void TestSerialiseJSON(clcpp::Database& db)
 		printf("STRUCT PASS!\n");
 	else
 		printf("STRUCT FAIL!\n");
+
+	// Decimals written as text must read back exactly, including those with no short representation
+	a.f20 = 0.1f;
+	a.f24 = 5e-324;
+	clutl::WriteBuffer decimal_write_buffer;
+	clutl::SaveJSON(decimal_write_buffer, &a, clcpp::GetType<jsontest::AllFields>(), 0);
+	clutl::ReadBuffer decimal_read_buffer(decimal_write_buffer);
+	jsontest::AllFields c(jsontest::NO_INIT);
+	clutl::LoadJSON(decimal_read_buffer, &c, clcpp::GetType<jsontest::AllFields>());
+
+	if (a == c)
+		printf("DECIMAL STRUCT PASS!\n");
+	else
+		printf("DECIMAL STRUCT FAIL!\n");
 }
@@ -53,8 +53,27 @@ namespace
 
 	void VisitContainerFields(clcpp::ReadIterator& reader, const clcpp::Field* field, const clutl::IFieldVisitor& visitor, clutl::VisitFieldType visit_type)
 	{
+		// Containers of values with no pointers in them have nothing to visit when only visiting pointers
+		const clcpp::Type* type = reader.m_ValueType;
+		if (visit_type == clutl::VFT_Pointers && !reader.m_ValueIsPtr &&
+			(type->kind == clcpp::Primitive::KIND_TYPE || type->kind == clcpp::Primitive::KIND_ENUM))
+			return;
+
 		// Visit each entry in the container - keys are discarded
 		clcpp::Qualifier qualifer(reader.m_ValueIsPtr ? clcpp::Qualifier::POINTER : clcpp::Qualifier::VALUE, false);
+
+		// Step through values stored contiguously without calling into the iterator for each one
+		const void* values;
+		unsigned int count;
+		if (reader.GetContiguous(values, count) && count == reader.m_Count)
+		{
+			clcpp::size_type value_size = reader.m_ValueIsPtr ? sizeof(void*) : type->size;
+			char* value = (char*)values;
+			for (unsigned int i = 0; i < count; i++, value += value_size)
+				VisitField(value, field, type, qualifer, visitor, visit_type);
+			return;
+		}
+
 		for (unsigned int i = 0; i < reader.m_Count; i++)
 		{
 			clcpp::ContainerKeyValue kv = reader.GetKeyValue();
@@ -81,10 +100,8 @@ namespace
 	}
 
 
-	void VisitClassFields(char* object, const clcpp::Class* class_type, const clutl::IFieldVisitor& visitor, clutl::VisitFieldType visit_type)
+	void VisitFieldArray(char* object, const clcpp::CArray<const clcpp::Field*>& fields, const clutl::IFieldVisitor& visitor, clutl::VisitFieldType visit_type)
 	{
-		// Visit all fields in the class
-		const clcpp::CArray<const clcpp::Field*>& fields = class_type->fields;
 		for (unsigned int i = 0; i < fields.size; i++)
 		{
 			const clcpp::Field* field = fields[i];
@@ -100,6 +117,20 @@ namespace
 
 			VisitField(object + field->offset, field, field->type, field->qualifier, visitor, visit_type);
 		}
+	}
+
+
+	void VisitClassFields(char* object, const clcpp::Class* class_type, const clutl::IFieldVisitor& visitor, clutl::VisitFieldType visit_type)
+	{
+		// Visit all fields of the class and its base types in one pass where possible
+		if (class_type->flattened_fields.size != 0)
+		{
+			VisitFieldArray(object, class_type->flattened_fields, visitor, visit_type);
+			return;
+		}
+
+		// Visit all fields in the class
+		VisitFieldArray(object, class_type->fields, visitor, visit_type);
 
 		// Visit the base types at the same offset
 		for (unsigned int i = 0; i < class_type->base_types.size; i++)
@@ -9,15 +9,163 @@
 //
 
 #include <clutl/JSONLexer.h>
+#include <clutl/Decimal.h>
 
 
-// Standard C library function, convert string to double-precision number
-// http://pubs.opengroup.org/onlinepubs/007904975/functions/strtod.html
-extern "C" double strtod(const char* s00, char** se);
+// Select the widest vector instructions the target is compiled for to build the structural index,
+// falling back to scalar code elsewhere
+#if defined(__AVX2__)
+	#define JSON_INDEX_AVX2
+	#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define JSON_INDEX_SSE2
+	#include <emmintrin.h>
+#endif
+
+#if defined(CLCPP_USING_MSVC)
+	#include <intrin.h>
+#endif
 
 
 namespace
 {
+	// Number of characters in each block of the structural index, one for each bit of a mask
+	const unsigned int INDEX_BLOCK_SIZE = 64;
+
+
+	unsigned int LowestBitIndex(clcpp::uint64 mask)
+	{
+	#if defined(CLCPP_USING_GNUC)
+		return __builtin_ctzll(mask);
+	#elif defined(CLCPP_USING_MSVC)
+		unsigned long index;
+		if (_BitScanForward(&index, (unsigned long)mask))
+			return index;
+		_BitScanForward(&index, (unsigned long)(mask >> 32));
+		return index + 32;
+	#else
+		unsigned int index = 0;
+		while ((mask & 1) == 0)
+		{
+			mask >>= 1;
+			index++;
+		}
+		return index;
+	#endif
+	}
+
+
+	//
+	// Classifies a block of INDEX_BLOCK_SIZE characters, setting a bit in each mask for every
+	// character that's whitespace, a newline, or a quote or escape
+	//
+	void ClassifyBlock(const char* data, clcpp::uint64& whitespace, clcpp::uint64& newlines, clcpp::uint64& strings)
+	{
+		whitespace = 0;
+		newlines = 0;
+		strings = 0;
+
+	#if defined(JSON_INDEX_AVX2)
+
+		for (unsigned int i = 0; i < INDEX_BLOCK_SIZE; i += 32)
+		{
+			// Whitespace is a space or a character in the range ['\t', '\r'], which includes newlines
+			__m256i c = _mm256_loadu_si256((const __m256i*)(data + i));
+			__m256i ws = _mm256_or_si256(
+				_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')),
+				_mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('\t' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), c)));
+			__m256i nl = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\n'));
+			__m256i str = _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('\"')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\\')));
+			whitespace |= (clcpp::uint64)(unsigned int)_mm256_movemask_epi8(ws) << i;
+			newlines |= (clcpp::uint64)(unsigned int)_mm256_movemask_epi8(nl) << i;
+			strings |= (clcpp::uint64)(unsigned int)_mm256_movemask_epi8(str) << i;
+		}
+
+	#elif defined(JSON_INDEX_SSE2)
+
+		for (unsigned int i = 0; i < INDEX_BLOCK_SIZE; i += 16)
+		{
+			// Whitespace is a space or a character in the range ['\t', '\r'], which includes newlines
+			__m128i c = _mm_loadu_si128((const __m128i*)(data + i));
+			__m128i ws = _mm_or_si128(
+				_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')),
+				_mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('\t' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('\r' + 1))));
+			__m128i nl = _mm_cmpeq_epi8(c, _mm_set1_epi8('\n'));
+			__m128i str = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('\"')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\\')));
+			whitespace |= (clcpp::uint64)(unsigned int)_mm_movemask_epi8(ws) << i;
+			newlines |= (clcpp::uint64)(unsigned int)_mm_movemask_epi8(nl) << i;
+			strings |= (clcpp::uint64)(unsigned int)_mm_movemask_epi8(str) << i;
+		}
+
+	#else
+
+		for (unsigned int i = 0; i < INDEX_BLOCK_SIZE; i++)
+		{
+			char c = data[i];
+			clcpp::uint64 bit = (clcpp::uint64)1 << i;
+			if (c == ' ' || (c >= '\t' && c <= '\r'))
+				whitespace |= bit;
+			if (c == '\n')
+				newlines |= bit;
+			if (c == '\"' || c == '\\')
+				strings |= bit;
+		}
+
+	#endif
+	}
+
+
+	bool NeedsEscape(char c)
+	{
+		return c == '\"' || c == '\\' || (unsigned char)c < 0x20;
+	}
+
+
+	//
+	// Counts the characters at the start of a string that can be written to JSON as they are,
+	// stopping at the first quote, backslash or control character
+	//
+	unsigned int EscapeRunLength(const char* str, unsigned int length)
+	{
+		unsigned int position = 0;
+
+	#if defined(JSON_INDEX_AVX2)
+
+		for (; position + 32 <= length; position += 32)
+		{
+			// Control characters are those that are unchanged by an unsigned max with 0x1F
+			__m256i c = _mm256_loadu_si256((const __m256i*)(str + position));
+			__m256i quote = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\"'));
+			__m256i backslash = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\\'));
+			__m256i control = _mm256_cmpeq_epi8(_mm256_max_epu8(c, _mm256_set1_epi8(0x1F)), _mm256_set1_epi8(0x1F));
+			unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(quote, backslash), control));
+			if (mask != 0)
+				return position + LowestBitIndex(mask);
+		}
+
+	#elif defined(JSON_INDEX_SSE2)
+
+		for (; position + 16 <= length; position += 16)
+		{
+			// Control characters are those that are unchanged by an unsigned max with 0x1F
+			__m128i c = _mm_loadu_si128((const __m128i*)(str + position));
+			__m128i quote = _mm_cmpeq_epi8(c, _mm_set1_epi8('\"'));
+			__m128i backslash = _mm_cmpeq_epi8(c, _mm_set1_epi8('\\'));
+			__m128i control = _mm_cmpeq_epi8(_mm_max_epu8(c, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F));
+			unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(quote, backslash), control));
+			if (mask != 0)
+				return position + LowestBitIndex(mask);
+		}
+
+	#endif
+
+		// Scalar tail, or the whole string without vector instructions
+		while (position < length && !NeedsEscape(str[position]))
+			position++;
+		return position;
+	}
+
+
 	bool isdigit(char c)
 	{
 		return c >= '0' && c <= '9';
@@ -28,12 +176,24 @@ namespace
 	}
 
 
-	int Lexer32bitHexDigits(clutl::JSONContext& ctx)
+	unsigned int HexDigitsValue(const char* digits)
+	{
+		unsigned int value = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			char c = digits[i];
+			value = value * 16 + (c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+		}
+		return value;
+	}
+
+
+	bool Lexer32bitHexDigits(clutl::JSONContext& ctx, unsigned int& code_unit)
 	{
 		// Skip the 'u' and check for overflow
 		ctx.ConsumeChar();
 		if (ctx.ReadOverflows(4))
-			return 0;
+			return false;
 
 		// Ensure the next 4 bytes are hex digits
 		// NOTE: \u is not valid - C has the equivalent \xhh and \xhhhh
@@ -43,46 +203,111 @@ namespace
 			ishexdigit(digits[2]) &&
 			ishexdigit(digits[3]))
 		{
+			code_unit = HexDigitsValue(digits);
 			ctx.ConsumeChars(4);
-			return 4;
+			return true;
 		}
 
 		ctx.SetError(clutl::JSONError::EXPECTING_HEX_DIGIT);
 
-		return 0;
+		return false;
 	}
 
 
-	int LexerEscapeSequence(clutl::JSONContext& ctx)
+	void WriteUTF8(clutl::WriteBuffer& out, unsigned int code_point)
+	{
+		char* dest;
+		if (code_point < 0x80)
+		{
+			out.WriteChar((char)code_point);
+		}
+		else if (code_point < 0x800)
+		{
+			dest = (char*)out.Alloc(2);
+			dest[0] = (char)(0xC0 | (code_point >> 6));
+			dest[1] = (char)(0x80 | (code_point & 0x3F));
+		}
+		else if (code_point < 0x10000)
+		{
+			dest = (char*)out.Alloc(3);
+			dest[0] = (char)(0xE0 | (code_point >> 12));
+			dest[1] = (char)(0x80 | ((code_point >> 6) & 0x3F));
+			dest[2] = (char)(0x80 | (code_point & 0x3F));
+		}
+		else
+		{
+			dest = (char*)out.Alloc(4);
+			dest[0] = (char)(0xF0 | (code_point >> 18));
+			dest[1] = (char)(0x80 | ((code_point >> 12) & 0x3F));
+			dest[2] = (char)(0x80 | ((code_point >> 6) & 0x3F));
+			dest[3] = (char)(0x80 | (code_point & 0x3F));
+		}
+	}
+
+
+	bool LexerUnicodeEscape(clutl::JSONContext& ctx, clutl::WriteBuffer& out)
+	{
+		unsigned int code_point;
+		if (!Lexer32bitHexDigits(ctx, code_point))
+			return false;
+
+		// Characters beyond the basic multilingual plane are encoded as a pair of UTF-16 surrogates
+		// and unpaired surrogates can't be represented in UTF-8, so are replaced with U+FFFD. As with
+		// other escape sequences, the low surrogate must be followed by at least one more character.
+		if (code_point >= 0xD800 && code_point <= 0xDFFF)
+		{
+			const char* next = ctx.PeekChars();
+			if (code_point <= 0xDBFF && ctx.Remaining() > 6 && next[0] == '\\' && next[1] == 'u' &&
+				ishexdigit(next[2]) && ishexdigit(next[3]) && ishexdigit(next[4]) && ishexdigit(next[5]))
+			{
+				unsigned int low = HexDigitsValue(next + 2);
+				if (low >= 0xDC00 && low <= 0xDFFF)
+				{
+					code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+					ctx.ConsumeChars(6);
+					WriteUTF8(out, code_point);
+					return true;
+				}
+			}
+			code_point = 0xFFFD;
+		}
+
+		WriteUTF8(out, code_point);
+		return true;
+	}
+
+
+	bool LexerEscapeSequence(clutl::JSONContext& ctx, clutl::WriteBuffer& out)
 	{
 		ctx.ConsumeChar();
 
 		if (ctx.ReadOverflows(0))
-			return 0;
+			return false;
 		char c = ctx.PeekChar();
 
 		switch (c)
 		{
-		// Pass all single character sequences
+		// Decode all single character sequences
 		case '\"':
 		case '\\':
-		case '/':
-		case 'b':
-		case 'n':
-		case 'f':
-		case 'r':
-		case 't':
-			ctx.ConsumeChar();
-			return 1;
+		case '/': out.WriteChar(c); break;
+		case 'b': out.WriteChar('\b'); break;
+		case 'n': out.WriteChar('\n'); break;
+		case 'f': out.WriteChar('\f'); break;
+		case 'r': out.WriteChar('\r'); break;
+		case 't': out.WriteChar('\t'); break;
 
 		// Parse the unicode hex digits
 		case 'u':
-			return 1 + Lexer32bitHexDigits(ctx);
+			return LexerUnicodeEscape(ctx, out);
 
 		default:
 			ctx.SetError(clutl::JSONError::INVALID_ESCAPE_SEQUENCE);
-			return 0;
+			return false;
 		}
+
+		ctx.ConsumeChar();
+		return true;
 	}
 
 
@@ -93,37 +318,46 @@ namespace
 		clutl::JSONToken token(clutl::JSON_TOKEN_STRING, 0);
 		token.val.string = ctx.PeekChars();
 
-		// The common case here is another character as opposed to quotes so
-		// keep looping until that happens
-		int len = 0;
+		// The common case here is a run of typical characters up to the closing quote, consumed in
+		// one go and referenced in-place
+		unsigned int run = ctx.StringRunLength();
+		ctx.ConsumeChars(run);
+		if (ctx.ReadOverflows(0))
+			return clutl::JSONToken();
+		if (ctx.PeekChar() == '\"')
+		{
+			ctx.ConsumeChar();
+			token.length = run;
+			return token;
+		}
+
+		// Otherwise decode the string, copying each run between escape sequences in one go
+		clutl::WriteBuffer& decoded = ctx.NextStringBuffer();
+		if (run != 0)
+			decoded.Write(token.val.string, run);
 		while (true)
 		{
+			if (!LexerEscapeSequence(ctx, decoded))
+				return clutl::JSONToken();
+
+			run = ctx.StringRunLength();
+			if (run != 0)
+				decoded.Write(ctx.PeekChars(), run);
+			ctx.ConsumeChars(run);
+
 			if (ctx.ReadOverflows(0))
 				return clutl::JSONToken();
-			char c = ctx.PeekChar();
 
-			switch (c)
-			{
 			// The string terminates with a quote
-			case '\"':
+			if (ctx.PeekChar() == '\"')
+			{
 				ctx.ConsumeChar();
-				return token;
-
-			// Escape sequence
-			case '\\':
-				len = LexerEscapeSequence(ctx);
-				if (len == 0)
-					return clutl::JSONToken();
-				token.length += 1 + len;
 				break;
-
-			// A typical string character
-			default:
-				ctx.ConsumeChar();
-				token.length++;
 			}
 		}
 
+		token.val.string = decoded.GetData();
+		token.length = decoded.GetBytesWritten();
 		return token;
 	}
 
@@ -143,20 +377,19 @@ namespace
 			return false;
 		}
 
+		// Accumulate all digits before consuming them in one go
+		const char* digits = ctx.PeekChars();
+		unsigned int remaining = ctx.Remaining();
+		unsigned int nb_digits = 0;
 		uintval = 0;
-		do 
+		do
 		{
-			// Consume and accumulate the digit
-			ctx.ConsumeChar();
-			uintval = (uintval * 10) + (c - '0');
+			uintval = (uintval * 10) + (digits[nb_digits++] - '0');
+		} while (nb_digits < remaining && isdigit(digits[nb_digits]));
+		ctx.ConsumeChars(nb_digits);
 
-			// Peek at the next character and leave if its not a digit
-			if (ctx.ReadOverflows(0))
-				return false;
-			c = ctx.PeekChar();
-		} while (isdigit(c));
-
-		return true;
+		// Leave if there's nothing after the digits
+		return !ctx.ReadOverflows(0);
 	}
 
 
@@ -300,13 +533,12 @@ namespace
 			if (!VerifyDecimal(ctx, decimal_start, ctx.Remaining()))
 				return clutl::JSONToken();
 
-			// Re-evaluate as a decimal using the more expensive strtod function
-			char* number_end;
+			// Re-evaluate as a correctly rounded decimal from the start of the number
 			token.type = clutl::JSON_TOKEN_DECIMAL;
-			token.val.decimal = strtod(number_start, &number_end);
+			unsigned int length = clutl::ParseDouble(number_start, (decimal_start - number_start) + ctx.Remaining(), token.val.decimal);
 
 			// Skip over the parsed decimal
-			ctx.ConsumeChars(number_end - decimal_start);
+			ctx.ConsumeChars(number_start + length - decimal_start);
 		}
 
 		return token;
@@ -318,24 +550,18 @@ namespace
 		// Consume the matched first letter
 		ctx.ConsumeChar();
 
-		// Try to match the remaining letters of the keyword
-		int dlen = len;
-		while (dlen)
-		{
-			if (ctx.ReadOverflows(0))
-				return clutl::JSONToken();
-
-			// Early out when keyword no longer matches
-			if (*keyword++ != ctx.PeekChar())
-				break;
-
-			ctx.ConsumeChar();
-			dlen--;
-		}
+		// Try to match the remaining letters of the keyword, stopping early when it no longer matches
+		const char* chars = ctx.PeekChars();
+		unsigned int remaining = ctx.Remaining();
+		int nb_matched = 0;
+		while (nb_matched < len && (unsigned int)nb_matched < remaining && chars[nb_matched] == keyword[nb_matched])
+			nb_matched++;
+		ctx.ConsumeChars(nb_matched);
 
-		if (dlen)
+		if (nb_matched != len)
 		{
-			ctx.SetError(clutl::JSONError::INVALID_KEYWORD);
+			if (!ctx.ReadOverflows(0))
+				ctx.SetError(clutl::JSONError::INVALID_KEYWORD);
 			return clutl::JSONToken();
 		}
 
@@ -348,6 +574,11 @@ clutl::JSONContext::JSONContext(clutl::ReadBuffer& read_buffer)
 	: m_ReadBuffer(read_buffer)
 	, m_Line(1)
 	, m_LinePosition(0)
+	, m_IndexPosition(0xFFFFFFFF)
+	, m_WhitespaceMask(0)
+	, m_NewlineMask(0)
+	, m_StringMask(0)
+	, m_StringBufferIndex(0)
 	, m_StackPosition(0xFFFFFFFF)
 {
 }
@@ -414,6 +645,97 @@ void clutl::JSONContext::IncLine()
 }
 
 
+void clutl::JSONContext::SkipWhitespace()
+{
+	while (true)
+	{
+		unsigned int position = m_ReadBuffer.GetBytesRead();
+		if (position >= m_ReadBuffer.GetTotalBytes())
+			return;
+		if (position < m_IndexPosition || position >= m_IndexPosition + INDEX_BLOCK_SIZE)
+			IndexBlock(position);
+
+		// Count the whitespace characters ahead in this block
+		unsigned int offset = position - m_IndexPosition;
+		clcpp::uint64 other = ~m_WhitespaceMask >> offset;
+		unsigned int count = other != 0 ? LowestBitIndex(other) : INDEX_BLOCK_SIZE - offset;
+
+		// Count any lines spanned, recording the position of the last newline
+		clcpp::uint64 newlines = m_NewlineMask >> offset;
+		if (count < INDEX_BLOCK_SIZE)
+			newlines &= ((clcpp::uint64)1 << count) - 1;
+		while (newlines != 0)
+		{
+			m_Line++;
+			m_LinePosition = position + LowestBitIndex(newlines);
+			newlines &= newlines - 1;
+		}
+
+		// Characters beyond the end of the data are never whitespace
+		if (count != 0)
+			m_ReadBuffer.SeekRel(count);
+		if (other != 0)
+			return;
+	}
+}
+
+
+unsigned int clutl::JSONContext::StringRunLength()
+{
+	unsigned int start = m_ReadBuffer.GetBytesRead();
+	unsigned int end = m_ReadBuffer.GetTotalBytes();
+	unsigned int position = start;
+	while (position < end)
+	{
+		if (position < m_IndexPosition || position >= m_IndexPosition + INDEX_BLOCK_SIZE)
+			IndexBlock(position);
+
+		// Stop at the first quote or escape, clamping blocks that extend beyond the data
+		unsigned int offset = position - m_IndexPosition;
+		clcpp::uint64 strings = m_StringMask >> offset;
+		if (strings != 0)
+		{
+			position += LowestBitIndex(strings);
+			break;
+		}
+		position = m_IndexPosition + INDEX_BLOCK_SIZE;
+	}
+
+	return (position < end ? position : end) - start;
+}
+
+
+clutl::WriteBuffer& clutl::JSONContext::NextStringBuffer()
+{
+	m_StringBufferIndex ^= 1;
+	clutl::WriteBuffer& buffer = m_StringBuffers[m_StringBufferIndex];
+	buffer.Reset();
+	return buffer;
+}
+
+
+void clutl::JSONContext::IndexBlock(unsigned int position)
+{
+	const char* data = m_ReadBuffer.ReadAt(position);
+
+	// Blocks that extend beyond the end of the data are classified from a padded copy
+	unsigned int remaining = m_ReadBuffer.GetTotalBytes() - position;
+	if (remaining < INDEX_BLOCK_SIZE)
+	{
+		char padded[INDEX_BLOCK_SIZE] = { 0 };
+		for (unsigned int i = 0; i < remaining; i++)
+			padded[i] = data[i];
+		ClassifyBlock(padded, m_WhitespaceMask, m_NewlineMask, m_StringMask);
+	}
+	else
+	{
+		ClassifyBlock(data, m_WhitespaceMask, m_NewlineMask, m_StringMask);
+	}
+
+	m_IndexPosition = position;
+}
+
+
 void clutl::JSONContext::PushState(const clutl::JSONToken& token)
 {
 	clcpp::internal::Assert(m_StackPosition == 0xFFFFFFFF);
@@ -441,25 +763,14 @@ void clutl::JSONContext::PopState(clutl::JSONToken& token)
 
 clutl::JSONToken clutl::LexerNextToken(clutl::JSONContext& ctx)
 {
-start:
-	// Read the current character and return an empty token at stream end
+	// Read the first character after any whitespace and return an empty token at stream end
+	ctx.SkipWhitespace();
 	if (ctx.ReadOverflows(0, clutl::JSONError::NONE))
 		return clutl::JSONToken();
 	char c = ctx.PeekChar();
 
 	switch (c)
 	{
-	// Branch to the start only if it's a whitespace (the least-common case)
-	case '\n':
-		ctx.IncLine();
-	case ' ':
-	case '\t':
-	case '\v':
-	case '\f':
-	case '\r':
-		ctx.ConsumeChar();
-		goto start;
-
 	// Structural single character tokens
 	case '{':
 	case '}':
@@ -498,3 +809,44 @@ start:
 		return clutl::JSONToken();
 	}
 }
+
+
+void clutl::EscapeJSONString(clutl::WriteBuffer& out, const char* str, unsigned int length)
+{
+	const char* end = str + length;
+	while (true)
+	{
+		// Copy the run of characters that don't need escaping in one go
+		unsigned int run = EscapeRunLength(str, end - str);
+		if (run != 0)
+			out.Write(str, run);
+		str += run;
+		if (str == end)
+			break;
+
+		// Use the short form escape sequences where they exist
+		char c = *str++;
+		char* dest = (char*)out.Alloc(2);
+		dest[0] = '\\';
+		switch (c)
+		{
+		case '\"': dest[1] = '\"'; break;
+		case '\\': dest[1] = '\\'; break;
+		case '\b': dest[1] = 'b'; break;
+		case '\f': dest[1] = 'f'; break;
+		case '\n': dest[1] = 'n'; break;
+		case '\r': dest[1] = 'r'; break;
+		case '\t': dest[1] = 't'; break;
+		default:
+			{
+				static const char hex_digits[] = "0123456789abcdef";
+				dest[1] = 'u';
+				dest = (char*)out.Alloc(4);
+				dest[0] = '0';
+				dest[1] = '0';
+				dest[2] = hex_digits[(c >> 4) & 0xF];
+				dest[3] = hex_digits[c & 0xF];
+			}
+		}
+	}
+}
@@ -24,11 +24,175 @@
 
 extern "C" void* CLCPP_CDECL memcpy(void* dst, const void* src, clcpp::size_type size) __THROW __nonnull ((1, 2));
 
+// Standard C library function, copy bytes between buffers that may overlap
+// http://pubs.opengroup.org/onlinepubs/009695399/functions/memmove.html
+extern "C" void* CLCPP_CDECL memmove(void* dst, const void* src, clcpp::size_type size) __THROW __nonnull ((1, 2));
+
+
+#if defined(CLCPP_PLATFORM_WINDOWS)
+
+	// Windows-specific virtual memory functions
+	extern "C" __declspec(dllimport) void* __stdcall VirtualAlloc(void* lpAddress, clcpp::pointer_type dwSize, unsigned long flAllocationType, unsigned long flProtect);
+	extern "C" __declspec(dllimport) int __stdcall VirtualFree(void* lpAddress, clcpp::pointer_type dwSize, unsigned long dwFreeType);
+	#define MEM_COMMIT 0x1000
+	#define MEM_RESERVE 0x2000
+	#define MEM_RELEASE 0x8000
+	#define PAGE_NOACCESS 0x01
+	#define PAGE_READWRITE 0x04
+
+	// Windows-specific file mapping functions
+	extern "C" __declspec(dllimport) void* __stdcall CreateFileA(const char* lpFileName, unsigned long dwDesiredAccess, unsigned long dwShareMode, void* lpSecurityAttributes, unsigned long dwCreationDisposition, unsigned long dwFlagsAndAttributes, void* hTemplateFile);
+	extern "C" __declspec(dllimport) int __stdcall GetFileSizeEx(void* hFile, long long* lpFileSize);
+	extern "C" __declspec(dllimport) void* __stdcall CreateFileMappingA(void* hFile, void* lpAttributes, unsigned long flProtect, unsigned long dwMaximumSizeHigh, unsigned long dwMaximumSizeLow, const char* lpName);
+	extern "C" __declspec(dllimport) void* __stdcall MapViewOfFile(void* hFileMappingObject, unsigned long dwDesiredAccess, unsigned long dwFileOffsetHigh, unsigned long dwFileOffsetLow, clcpp::pointer_type dwNumberOfBytesToMap);
+	extern "C" __declspec(dllimport) int __stdcall UnmapViewOfFile(const void* lpBaseAddress);
+	extern "C" __declspec(dllimport) int __stdcall CloseHandle(void* hObject);
+	#define GENERIC_READ 0x80000000
+	#define FILE_SHARE_READ 0x01
+	#define OPEN_EXISTING 3
+	#define FILE_ATTRIBUTE_NORMAL 0x80
+	#define INVALID_HANDLE_VALUE ((void*)-1)
+	#define PAGE_READONLY 0x02
+	#define FILE_MAP_READ 0x04
+
+#elif defined(CLCPP_PLATFORM_POSIX)
+
+	// POSIX memory mapping functions, reserving memory with an anonymous mapping that can't be
+	// accessed until its protection is changed. The flags vary between platforms so they're taken
+	// from the system headers.
+	#include <sys/mman.h>
+	#define RESERVE_PROT PROT_NONE
+	#define COMMIT_PROT (PROT_READ | PROT_WRITE)
+	#define RESERVE_FLAGS (MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE)
+
+	// POSIX file functions for mapping files as read-only, private to the process
+	#include <fcntl.h>
+	#include <unistd.h>
+	#define OPEN_FLAGS O_RDONLY
+	#define MAP_FILE_PROT PROT_READ
+	#define MAP_FILE_FLAGS MAP_PRIVATE
+
+#endif
+
+
+namespace
+{
+	// Memory is committed to reserved address ranges in multiples of this, which is the allocation
+	// granularity on Windows and a multiple of page sizes elsewhere
+	const unsigned int COMMIT_GRANULARITY = 64 * 1024;
+
+
+	unsigned int RoundUpToCommit(unsigned int size)
+	{
+		return (size + COMMIT_GRANULARITY - 1) & ~(COMMIT_GRANULARITY - 1);
+	}
+
+
+	char* ReserveMemory(unsigned int size)
+	{
+	#if defined(CLCPP_PLATFORM_WINDOWS)
+		return (char*)VirtualAlloc(0, size, MEM_RESERVE, PAGE_NOACCESS);
+	#elif defined(CLCPP_PLATFORM_POSIX)
+		void* data = mmap(0, size, RESERVE_PROT, RESERVE_FLAGS, -1, 0);
+		return data != MAP_FAILED ? (char*)data : 0;
+	#else
+		return 0;
+	#endif
+	}
+
+
+	bool CommitMemory(char* data, unsigned int size)
+	{
+	#if defined(CLCPP_PLATFORM_WINDOWS)
+		return VirtualAlloc(data, size, MEM_COMMIT, PAGE_READWRITE) != 0;
+	#elif defined(CLCPP_PLATFORM_POSIX)
+		return mprotect(data, size, COMMIT_PROT) == 0;
+	#else
+		return false;
+	#endif
+	}
+
+
+	void ReleaseMemory(char* data, unsigned int size)
+	{
+	#if defined(CLCPP_PLATFORM_WINDOWS)
+		VirtualFree(data, 0, MEM_RELEASE);
+	#elif defined(CLCPP_PLATFORM_POSIX)
+		munmap(data, size);
+	#endif
+	}
+
+
+	bool MapFile(const char* filename, const char*& data, unsigned int& size)
+	{
+	#if defined(CLCPP_PLATFORM_WINDOWS)
+		void* file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		long long file_size = 0;
+		bool mapped = GetFileSizeEx(file, &file_size) != 0 && file_size <= 0xFFFFFFFF;
+
+		// Empty files can't be mapped and are opened with no data
+		if (mapped && file_size > 0)
+		{
+			// The view keeps the mapping open after its handle is closed
+			void* mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+			if (mapping != 0)
+			{
+				data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				CloseHandle(mapping);
+			}
+			mapped = data != 0;
+		}
+		CloseHandle(file);
+
+	#elif defined(CLCPP_PLATFORM_POSIX)
+		int fd = open(filename, OPEN_FLAGS);
+		if (fd < 0)
+			return false;
+		long file_size = lseek(fd, 0, SEEK_END);
+		bool mapped = file_size >= 0 && file_size <= 0xFFFFFFFF;
+
+		// Empty files can't be mapped and are opened with no data
+		if (mapped && file_size > 0)
+		{
+			void* mapping = mmap(0, file_size, MAP_FILE_PROT, MAP_FILE_FLAGS, fd, 0);
+			if (mapping != MAP_FAILED)
+				data = (const char*)mapping;
+			mapped = data != 0;
+		}
+		close(fd);
+
+	#else
+		bool mapped = false;
+		unsigned int file_size = 0;
+	#endif
+
+		size = mapped ? (unsigned int)file_size : 0;
+		return mapped;
+	}
+
+
+	void UnmapFile(const char* data, unsigned int size)
+	{
+	#if defined(CLCPP_PLATFORM_WINDOWS)
+		UnmapViewOfFile(data);
+	#elif defined(CLCPP_PLATFORM_POSIX)
+		munmap((void*)data, size);
+	#endif
+	}
+}
+
 
 clutl::WriteBuffer::WriteBuffer()
 	: m_Data(0)
 	, m_DataEnd(0)
 	, m_DataWrite(0)
+	, m_DataReservedEnd(0)
+	, m_Sink(0)
+	, m_BytesFlushed(0)
+	, m_NbPins(0)
+	, m_PinPosition(0)
 {
 }
 
@@ -37,6 +201,11 @@ clutl::WriteBuffer::WriteBuffer(unsigned int initial_capacity)
 	: m_Data(0)
 	, m_DataEnd(0)
 	, m_DataWrite(0)
+	, m_DataReservedEnd(0)
+	, m_Sink(0)
+	, m_BytesFlushed(0)
+	, m_NbPins(0)
+	, m_PinPosition(0)
 {
 	// Allocate initial capacity
 	m_Data = new char[initial_capacity];
@@ -45,9 +214,61 @@ clutl::WriteBuffer::WriteBuffer(unsigned int initial_capacity)
 }
 
 
-clutl::WriteBuffer::~WriteBuffer()
+clutl::WriteBuffer::WriteBuffer(unsigned int initial_capacity, unsigned int max_capacity)
+	: m_Data(0)
+	, m_DataEnd(0)
+	, m_DataWrite(0)
+	, m_DataReservedEnd(0)
+	, m_Sink(0)
+	, m_BytesFlushed(0)
+	, m_NbPins(0)
+	, m_PinPosition(0)
 {
+	// Reserve the address range and commit the initial capacity within it
+	unsigned int reserve_size = RoundUpToCommit(max_capacity);
+	if (reserve_size != 0)
+		m_Data = ReserveMemory(reserve_size);
 	if (m_Data != 0)
+	{
+		m_DataEnd = m_Data;
+		m_DataWrite = m_Data;
+		m_DataReservedEnd = m_Data + reserve_size;
+		if (initial_capacity != 0)
+			Grow(initial_capacity);
+	}
+
+	// Fall back to the heap if the range can't be reserved
+	else if (initial_capacity != 0)
+	{
+		m_Data = new char[initial_capacity];
+		m_DataEnd = m_Data + initial_capacity;
+		m_DataWrite = m_Data;
+	}
+}
+
+
+clutl::WriteBuffer::WriteBuffer(IStreamSink* sink, unsigned int chunk_size)
+	: m_Data(0)
+	, m_DataEnd(0)
+	, m_DataWrite(0)
+	, m_DataReservedEnd(0)
+	, m_Sink(sink)
+	, m_BytesFlushed(0)
+	, m_NbPins(0)
+	, m_PinPosition(0)
+{
+	clcpp::internal::Assert(sink != 0);
+	m_Data = new char[chunk_size];
+	m_DataEnd = m_Data + chunk_size;
+	m_DataWrite = m_Data;
+}
+
+
+clutl::WriteBuffer::~WriteBuffer()
+{
+	if (m_DataReservedEnd != 0)
+		ReleaseMemory(m_Data, m_DataReservedEnd - m_Data);
+	else if (m_Data != 0)
 		delete [] m_Data;
 }
 
@@ -55,33 +276,14 @@ clutl::WriteBuffer::~WriteBuffer()
 void clutl::WriteBuffer::Reset()
 {
 	m_DataWrite = m_Data;
+	m_BytesFlushed = 0;
 }
 
 
 void* clutl::WriteBuffer::Alloc(unsigned int length)
 {
-	// TODO: On platforms that support virtual memory, copy can be eliminated
 	if (m_DataWrite + length > m_DataEnd)
-	{
-		// Repeatedly calculate a new capacity of 1.5x until the new data fits
-		unsigned int new_capacity = (m_Data == 0) ? 32 : m_DataEnd - m_Data;
-		unsigned int write_pos = m_DataWrite - m_Data;
-		while (write_pos + length > new_capacity)
-			new_capacity += new_capacity / 2;
-
-		// Allocate the new data and copy over
-		char* new_data = new char[new_capacity];
-		if (m_Data != 0)
-		{
-			memcpy(new_data, m_Data, m_DataWrite - m_Data);
-			delete [] m_Data;
-		}
-
-		// Swap in the new buffer
-		m_Data = new_data;
-		m_DataEnd = m_Data + new_capacity;
-		m_DataWrite = m_Data + write_pos;
-	}
+		Grow(length);
 
 	// Advance the write pointer by the desired amount
 	void* data_write = m_DataWrite;
@@ -90,6 +292,59 @@ void* clutl::WriteBuffer::Alloc(unsigned int length)
 }
 
 
+void clutl::WriteBuffer::Grow(unsigned int length)
+{
+	// Make room by flushing, only growing the buffer if too much of it is pinned
+	if (m_Sink != 0)
+	{
+		Flush();
+		if (m_DataWrite + length <= m_DataEnd)
+			return;
+	}
+
+	unsigned int write_pos = m_DataWrite - m_Data;
+	unsigned int capacity = m_DataEnd - m_Data;
+
+	if (m_DataReservedEnd != 0)
+	{
+		// Commit at least half as much again as is already committed so that large buffers grow in
+		// few steps, without going beyond the reserved range
+		unsigned int reserved = m_DataReservedEnd - m_Data;
+		clcpp::internal::Assert(length <= reserved - write_pos && "Reserved capacity exceeded");
+		unsigned int new_capacity = write_pos + length;
+		if (new_capacity < capacity + capacity / 2)
+			new_capacity = capacity + capacity / 2;
+		new_capacity = RoundUpToCommit(new_capacity);
+		if (new_capacity > reserved)
+			new_capacity = reserved;
+
+		// Commit the new pages in-place
+		bool committed = CommitMemory(m_DataEnd, new_capacity - capacity);
+		clcpp::internal::Assert(committed && "Failed to commit reserved memory");
+		m_DataEnd = m_Data + new_capacity;
+		return;
+	}
+
+	// Repeatedly calculate a new capacity of 1.5x until the new data fits
+	unsigned int new_capacity = (m_Data == 0) ? 32 : capacity;
+	while (write_pos + length > new_capacity)
+		new_capacity += new_capacity / 2;
+
+	// Allocate the new data and copy over
+	char* new_data = new char[new_capacity];
+	if (m_Data != 0)
+	{
+		memcpy(new_data, m_Data, write_pos);
+		delete [] m_Data;
+	}
+
+	// Swap in the new buffer
+	m_Data = new_data;
+	m_DataEnd = m_Data + new_capacity;
+	m_DataWrite = m_Data + write_pos;
+}
+
+
 void clutl::WriteBuffer::Write(const void* data, unsigned int length)
 {
 	// Allocate enough space for the data and copy it
@@ -124,10 +379,40 @@ void clutl::WriteBuffer::SeekRel(int offset)
 }
 
 
+void clutl::WriteBuffer::Flush()
+{
+	if (m_Sink == 0)
+		return;
+
+	// Send everything before the first pin
+	char* flush_end = m_NbPins != 0 ? GetDataAt(m_PinPosition) : m_DataWrite;
+	unsigned int flush_size = flush_end - m_Data;
+	if (flush_size == 0)
+		return;
+	m_Sink->Write(m_Data, flush_size);
+
+	// Move any pinned data to the start of the buffer
+	unsigned int pinned_size = m_DataWrite - flush_end;
+	memmove(m_Data, flush_end, pinned_size);
+	m_DataWrite = m_Data + pinned_size;
+	m_BytesFlushed += flush_size;
+}
+
+
 clutl::ReadBuffer::ReadBuffer(const WriteBuffer& write_buffer)
 	: m_Data(write_buffer.GetData())
 	, m_DataEnd(write_buffer.GetData() + write_buffer.GetBytesWritten())
 	, m_DataRead(write_buffer.GetData())
+{
+	// Flushed data is no longer available
+	clcpp::internal::Assert(write_buffer.GetBytesFlushed() == 0);
+}
+
+
+clutl::ReadBuffer::ReadBuffer(const void* data, unsigned int size)
+	: m_Data((const char*)data)
+	, m_DataEnd((const char*)data + size)
+	, m_DataRead((const char*)data)
 {
 }
 
@@ -153,3 +438,32 @@ void clutl::ReadBuffer::SeekRel(int offset)
 	clcpp::internal::Assert(m_DataRead + offset <= m_DataEnd && "Seek overflow");
 	m_DataRead += offset;
 }
+
+
+clutl::MappedFile::MappedFile()
+	: m_Data(0)
+	, m_Size(0)
+{
+}
+
+
+clutl::MappedFile::~MappedFile()
+{
+	Close();
+}
+
+
+bool clutl::MappedFile::Open(const char* filename)
+{
+	Close();
+	return MapFile(filename, m_Data, m_Size);
+}
+
+
+void clutl::MappedFile::Close()
+{
+	if (m_Data != 0)
+		UnmapFile(m_Data, m_Size);
+	m_Data = 0;
+	m_Size = 0;
+}
@@ -9,27 +9,17 @@
 //
 // TODO:
 //    * Allow names to be specified as CRCs?
-//    * Escape sequences need converting.
 //    * Enums communicated by value (load integer checks for enum - could have a verify mode to ensure the constant exists).
 //    * Field names need to be in memory for JSON serialising to work.
 //
 
 #include <clutl/Serialise.h>
 #include <clutl/JSONLexer.h>
+#include <clutl/Decimal.h>
 #include <clcpp/Containers.h>
 #include <clcpp/FunctionCall.h>
 
 
-// Explicitly stated dependencies in stdlib.h
-// Non-standard, writes at most n bytes to dest with printf formatting
-#if defined(CLCPP_PLATFORM_WINDOWS)
-	extern "C" int _snprintf(char* dest, unsigned int n, const char* fmt, ...);
-	#define snprintf _snprintf
-#else
-	extern "C" int snprintf(char* dest, unsigned int n, const char* fmt, ...);
-#endif
-
-
 static void SetupTypeDispatchLUT();
 
 
@@ -129,7 +119,7 @@ namespace
 			const clcpp::Enum* enum_type = type->AsEnum();
 
 			// Is the enum a series of flags?
-			static unsigned int hash = clcpp::internal::HashNameString("flags");
+			static const unsigned int hash = CLCPP_NAME_HASH("flags");
 			bool are_flags = clcpp::FindPrimitive(enum_type->attributes, hash) != 0 ? true : false;
 			if (are_flags)
 			{
@@ -240,21 +230,73 @@ namespace
 	}
 
 
-	int ParserElements(clutl::JSONContext& ctx, clutl::JSONToken& t, clcpp::WriteIterator* writer, const clcpp::Type* type, clcpp::Qualifier::Operator op)
+	struct KeyObject
 	{
-		// Expect a value first
-		if (writer)
-			ParserValue(ctx, t, (char*)writer->AddEmpty(), type, op, 0);
-		else
-			ParserValue(ctx, t, 0, 0, op, 0);
+		// Temporary storage for the keys of a container as they're loaded, constructed once and
+		// reused for every key
+		KeyObject(const clcpp::Type* type)
+			: class_type(type->kind == clcpp::Primitive::KIND_CLASS ? type->AsClass() : 0)
+			, data((char*)buffer.Alloc(type->size))
+		{
+			for (clcpp::size_type i = 0; i < type->size; i++)
+				data[i] = 0;
+			if (class_type != 0 && class_type->constructor != 0)
+				clcpp::CallFunction(class_type->constructor, data);
+		}
 
-		if (t.type == clutl::JSON_TOKEN_COMMA)
+		~KeyObject()
 		{
-			t = LexerNextToken(ctx);
-			return 1 + ParserElements(ctx, t, writer, type, op);
+			if (class_type != 0 && class_type->destructor != 0)
+				clcpp::CallFunction(class_type->destructor, data);
 		}
 
-		return 1;
+		clutl::WriteBuffer buffer;
+		const clcpp::Class* class_type;
+		char* data;
+	};
+
+
+	void ParserKeyValue(clutl::JSONContext& ctx, clutl::JSONToken& t, clcpp::WriteIterator& writer, KeyObject& key, const clcpp::Type* type, clcpp::Qualifier::Operator op)
+	{
+		// Values of containers with keys are [key,value] pairs, with the value added under its key
+		if (!Expect(ctx, t, clutl::JSON_TOKEN_LBRACKET).IsValid())
+			return;
+		ParserValue(ctx, t, key.data, writer.m_KeyType, clcpp::Qualifier::VALUE, 0);
+		if (!Expect(ctx, t, clutl::JSON_TOKEN_COMMA).IsValid())
+			return;
+		ParserValue(ctx, t, (char*)writer.AddEmpty(key.data), type, op, 0);
+		Expect(ctx, t, clutl::JSON_TOKEN_RBRACKET);
+	}
+
+
+	void ParserElements(clutl::JSONContext& ctx, clutl::JSONToken& t, clcpp::WriteIterator* writer, const clcpp::Type* type, clcpp::Qualifier::Operator op)
+	{
+		if (writer && writer->m_KeyType)
+		{
+			KeyObject key(writer->m_KeyType);
+			while (true)
+			{
+				ParserKeyValue(ctx, t, *writer, key, type, op);
+				if (t.type != clutl::JSON_TOKEN_COMMA)
+					break;
+				t = LexerNextToken(ctx);
+			}
+			return;
+		}
+
+		// Iterate, rather than recurse, so that large arrays don't exhaust the stack
+		while (true)
+		{
+			// Expect a value first
+			if (writer)
+				ParserValue(ctx, t, (char*)writer->AddEmpty(), type, op, 0);
+			else
+				ParserValue(ctx, t, 0, 0, op, 0);
+
+			if (t.type != clutl::JSON_TOKEN_COMMA)
+				break;
+			t = LexerNextToken(ctx);
+		}
 	}
 
 
@@ -279,17 +321,13 @@ namespace
 
 		else if (type && type->ci)
 		{
-			// Do a pre-pass on the array to count the number of elements
-			// Really not very efficient for big collections of large objects
-			ctx.PushState(t);
-			int array_count = ParserElements(ctx, t, 0, 0, clcpp::Qualifier::VALUE);
-			ctx.PopState(t);
-
-			// Template types are dynamic container iterators
-			writer.Initialise(type->AsTemplateType(), object, array_count);
+			// Template types are dynamic container iterators that grow as each element is
+			// parsed, leaving the array to be lexed only once
+			writer.Initialise(type->AsTemplateType(), object);
 		}
 
-		if (writer.IsInitialised())
+		// Pointer keys can't be loaded so their containers are skipped
+		if (writer.IsInitialised() && !writer.m_KeyIsPtr)
 			ParserElements(ctx, t, &writer, writer.m_ValueType, writer.m_ValueIsPtr ? clcpp::Qualifier::POINTER : clcpp::Qualifier::VALUE);
 		else
 			ParserElements(ctx, t, 0, 0, clcpp::Qualifier::VALUE);
@@ -315,7 +353,7 @@ namespace
 			if (class_type->flag_attributes & clcpp::FlagAttribute::CUSTOM_LOAD)
 			{
 				// Look it up
-				static unsigned int hash = clcpp::internal::HashNameString("load_json");
+				static const unsigned int hash = CLCPP_NAME_HASH("load_json");
 				if (const clcpp::Attribute* attr = clcpp::FindPrimitive(class_type->attributes, hash))
 				{
 					const clcpp::PrimitiveAttribute* name_attr = attr->AsPrimitiveAttribute();
@@ -444,7 +482,7 @@ namespace
 			// Run any attached post-load functions
 			if (class_type->flag_attributes & clcpp::FlagAttribute::POST_LOAD)
 			{
-				static unsigned int hash = clcpp::internal::HashNameString("post_load");
+				static const unsigned int hash = CLCPP_NAME_HASH("post_load");
 				if (const clcpp::Attribute* attr = clcpp::FindPrimitive(class_type->attributes, hash))
 				{
 					const clcpp::PrimitiveAttribute* name_attr = attr->AsPrimitiveAttribute();
@@ -489,16 +527,17 @@ namespace
 	void SaveString(clutl::WriteBuffer& out, const char* start, const char* end)
 	{
 		out.WriteChar('\"');
-		out.Write(start, end - start);
+		clutl::EscapeJSONString(out, start, end - start);
 		out.WriteChar('\"');
 	}
 
 
 	void SaveString(clutl::WriteBuffer& out, const char* str)
 	{
-		out.WriteChar('\"');
-		out.WriteStr(str);
-		out.WriteChar('\"');
+		const char* end = str;
+		while (*end)
+			end++;
+		SaveString(out, str, end);
 	}
 
 
@@ -607,10 +646,9 @@ namespace
 			return;
 		}
 
-		// Serialise full float rep
-		char float_buffer[512];
-		int count = snprintf(float_buffer, sizeof(float_buffer), "%f", decimal);
-		out.Write(float_buffer, count);
+		// Shortest representation that reads back as the same double
+		char buffer[clutl::MAX_DECIMAL_CHARS];
+		out.Write(buffer, clutl::FormatDouble(buffer, decimal));
 	}
 
 
@@ -620,7 +658,16 @@ namespace
 	}
 	void SaveFloat(clutl::WriteBuffer& out, const char* object, unsigned int flags)
 	{
-		SaveDecimal(out, *(float*)object, flags);
+		if (flags & clutl::JSONFlags::EMIT_HEX_FLOATS)
+		{
+			SaveDecimal(out, *(float*)object, flags);
+			return;
+		}
+
+		// Floats have shorter representations of their own, which are still exact when read as a double and
+		// then cast back to float
+		char buffer[clutl::MAX_DECIMAL_CHARS];
+		out.Write(buffer, clutl::FormatFloat(buffer, *(float*)object));
 	}
 
 
@@ -639,13 +686,36 @@ namespace
 		int value = *(int*)object;
 
 		// Is the enum a series of flags?
-		static unsigned int hash = clcpp::internal::HashNameString("flags");
+		static const unsigned int hash = CLCPP_NAME_HASH("flags");
 		bool are_flags = clcpp::FindPrimitive(enum_type->attributes, hash) != 0 ? true : false;
 		if (are_flags && value != 0)
 		{
-			// Linear search of all enum values testing to see if they're set as flags
+			// Write each set bit that has its own constant, in bit order. Older versions wrote the
+			// constants in the order of the enum's constant array, using multi-bit constants
+			// wherever they came first, so re-saving older files can reorder or split
+			// their flags. The loaded value is the same either way.
 			bool enum_written = false;
-			for (unsigned int i = 0; i < enum_type->constants.size; i++)
+			const clcpp::CArray<const clcpp::EnumConstant*>& flag_constants = enum_type->flag_constants;
+			for (unsigned int i = 0; i < flag_constants.size && value != 0; i++)
+			{
+				const clcpp::EnumConstant* constant = flag_constants.data[i];
+				if (constant != 0 && (value & constant->value) != 0)
+				{
+					// Save as a series of OR operations
+					if (enum_written)
+						out.WriteChar('|');
+					else
+						out.WriteChar('\"');
+					out.WriteStr(constant->name.text);
+
+					value &= ~constant->value;
+					enum_written = true;
+				}
+			}
+
+			// Linear search of all enum values testing to see if they're set as flags, for any
+			// bits that can only be matched by multi-bit constants
+			for (unsigned int i = 0; i < enum_type->constants.size && value != 0; i++)
 			{
 				int enum_value = enum_type->constants[i]->value;
 				if ((value & enum_value) != 0)
@@ -660,8 +730,6 @@ namespace
 					// Clear out flag and keep going if it's not finished
 					value &= ~enum_value;
 					enum_written = true;
-					if (value == 0)
-						break;
 				}
 			}
 
@@ -672,18 +740,11 @@ namespace
 		}
 		else
 		{
-			// Do a linear search for an enum with a matching value
+			// Search for an enum with a matching value
 			// Also comes through here looking for match when value=0
 			const char* enum_name = "clReflect_JSON_EnumValueNotFound";
-			for (unsigned int i = 0; i < enum_type->constants.size; i++)
-			{
-				int enum_value = enum_type->constants[i]->value;
-				if (enum_value == value)
-				{
-					enum_name = enum_type->constants[i]->name.text;
-					break;
-				}
-			}
+			if (const clcpp::EnumConstant* constant = enum_type->FindConstantByValue(value))
+				enum_name = constant->name.text;
 
 			// Write the enum name as the value
 			SaveString(out, enum_name);
@@ -709,37 +770,84 @@ namespace
 	}
 
 
+	void SaveContiguousValues(clutl::WriteBuffer& out, const char* values, unsigned int count, const clcpp::Field* field, const clcpp::Type* type, clutl::IPtrSave* ptr_save, unsigned int flags)
+	{
+		// Look up the save function for primitive types once for the whole run
+		SaveNumberFunc func = 0;
+		if (type->kind == clcpp::Primitive::KIND_TYPE)
+		{
+			unsigned int index = GetTypeDispatchIndex(type->name.hash);
+			clcpp::internal::Assert(index < g_TypeDispatchMod && "Index is out of range");
+			func = g_TypeDispatchLUT[index].save_number;
+			clcpp::internal::Assert(func && "No save function for type");
+		}
+
+		// Save comma-separated objects
+		for (unsigned int i = 0; i < count; i++, values += type->size)
+		{
+			if (i != 0)
+				out.WriteChar(',');
+
+			if (func != 0)
+				func(out, values, flags);
+			else
+				SaveObject(out, values, field, type, ptr_save, flags);
+		}
+	}
+
+
 	void SaveContainer(clutl::WriteBuffer& out, clcpp::ReadIterator& reader, const clcpp::Field* field, clutl::IPtrSave* ptr_save, unsigned int flags)
 	{
-		// TODO: If the iterator has a key, save a dictionary instead.
 		// TODO: The reader knows its type and if its a pointer for all entries. Can early out on unwanted pointer saves, etc.
 
+		// Pointer keys can't be loaded so their containers are saved empty
+		if (reader.m_KeyIsPtr)
+		{
+			out.WriteStr("[]");
+			return;
+		}
+
 		out.WriteChar('[');
 
-		// Save comma-separated objects
+		// Values stored contiguously can be saved without calling into the iterator for each one
+		const void* values;
+		unsigned int count;
+		if (!reader.m_ValueIsPtr && reader.GetContiguous(values, count) && count == reader.m_Count)
+		{
+			SaveContiguousValues(out, (const char*)values, count, field, reader.m_ValueType, ptr_save, flags);
+			out.WriteChar(']');
+			return;
+		}
+
+		// Save comma-separated objects, or [key,value] pairs if the container has keys, as keys
+		// needn't be strings
 		bool written = false;
-		for (unsigned int i = 0; i < reader.m_Count; i++)
+		for (unsigned int i = 0; i < reader.m_Count; i++, reader.MoveNext())
 		{
 			clcpp::ContainerKeyValue kv = reader.GetKeyValue();
 
+			// Ask the user if they want to save this pointer
+			if (reader.m_ValueIsPtr && (ptr_save == 0 || !ptr_save->CanSavePtr(*(void**)kv.value, field, reader.m_ValueType)))
+				continue;
+
 			if (written)
 				out.WriteChar(',');
 
-			if (reader.m_ValueIsPtr)
+			if (reader.m_KeyType != 0)
 			{
-				// Ask the user if they want to save this pointer
-				void* ptr = *(void**)kv.value;
-				if (ptr_save == 0 || !ptr_save->CanSavePtr(ptr, field, reader.m_ValueType))
-					continue;
+				out.WriteChar('[');
+				SaveObject(out, (char*)kv.key, field, reader.m_KeyType, ptr_save, flags);
+				out.WriteChar(',');
+			}
 
+			if (reader.m_ValueIsPtr)
 				SavePtr(out, kv.value, ptr_save, flags);
-			}
 			else
-			{
 				SaveObject(out, (char*)kv.value, field, reader.m_ValueType, ptr_save, flags);
-			}
 
-			reader.MoveNext();
+			if (reader.m_KeyType != 0)
+				out.WriteChar(']');
+
 			written = true;
 		}
 
@@ -912,6 +1020,25 @@ namespace
 
 	void SaveClass(clutl::WriteBuffer& out, const char* object, const clcpp::Type* type, clutl::IPtrSave* ptr_save, unsigned int& flags, bool& field_written)
 	{
+		// The flattened fields are already in offset order, with those of the base types first
+		if ((flags & clutl::JSONFlags::SORT_CLASS_FIELDS_BY_OFFSET) != 0 && type->kind == clcpp::Primitive::KIND_CLASS)
+		{
+			const clcpp::CArray<const clcpp::Field*>& fields = type->AsClass()->flattened_fields;
+			if (fields.size != 0)
+			{
+				for (unsigned int i = 0; i < fields.size; i++)
+				{
+					// Skip transient fields
+					const clcpp::Field* field = fields[i];
+					if (field->flag_attributes & clcpp::FlagAttribute::TRANSIENT)
+						continue;
+
+					SaveClassField(out, object, field, ptr_save, flags, field_written);
+				}
+				return;
+			}
+		}
+
 		// Save body of the class
 		if (type->kind == clcpp::Primitive::KIND_CLASS)
 			SaveClassFields(out, object, type->AsClass(), ptr_save, flags, field_written);
@@ -931,7 +1058,7 @@ namespace
 		if (class_type->flag_attributes & clcpp::FlagAttribute::CUSTOM_SAVE)
 		{
 			// Look it up
-			static unsigned int hash = clcpp::internal::HashNameString("save_json");
+			static const unsigned int hash = CLCPP_NAME_HASH("save_json");
 			if (const clcpp::Attribute* attr = clcpp::FindPrimitive(class_type->attributes, hash))
 			{
 				const clcpp::PrimitiveAttribute* name_attr = attr->AsPrimitiveAttribute();
@@ -963,7 +1090,7 @@ namespace
 		// Call any attached pre-save function
 		if (class_type->flag_attributes & clcpp::FlagAttribute::PRE_SAVE)
 		{
-			static unsigned int hash = clcpp::internal::HashNameString("pre_save");
+			static const unsigned int hash = CLCPP_NAME_HASH("pre_save");
 			if (const clcpp::Attribute* attr = clcpp::FindPrimitive(class_type->attributes, hash))
 			{
 				const clcpp::PrimitiveAttribute* name_attr = attr->AsPrimitiveAttribute();
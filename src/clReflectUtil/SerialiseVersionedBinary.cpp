@@ -9,10 +9,29 @@
 //
 
 #include <clutl/Serialise.h>
+#include <clutl/Objects.h>
 #include <clcpp/FunctionCall.h>
 #include <clcpp/Containers.h>
 
 
+// Standard C library function, copy bytes
+// http://pubs.opengroup.org/onlinepubs/009695399/functions/memcpy.html
+
+#ifdef __GNUC__
+	#define __THROW	throw ()
+	#define __nonnull(params) __attribute__ ((__nonnull__ params))
+#else
+	#define __THROW
+	#define __nonnull(params)
+#endif
+
+extern "C" void* CLCPP_CDECL memcpy(void* dst, const void* src, clcpp::size_type size) __THROW __nonnull ((1, 2));
+
+// Standard C library function, copy bytes between buffers that may overlap
+// http://pubs.opengroup.org/onlinepubs/009695399/functions/memmove.html
+extern "C" void* CLCPP_CDECL memmove(void* dst, const void* src, clcpp::size_type size) __THROW __nonnull ((1, 2));
+
+
 namespace
 {
 	struct ChunkHeader
@@ -45,17 +64,191 @@ namespace
 	};
 
 
+	//
+	// Minimal growable array for recording the objects and pointers in a graph, and the chunk sizes
+	// of streamed graphs
+	//
+	template <typename TYPE>
+	class GrowArray
+	{
+	public:
+		GrowArray()
+			: m_Data(0)
+			, m_Size(0)
+			, m_Capacity(0)
+		{
+		}
+
+		~GrowArray()
+		{
+			if (m_Data != 0)
+				delete [] m_Data;
+		}
+
+		void Add(const TYPE& value)
+		{
+			if (m_Size == m_Capacity)
+			{
+				// Double the capacity and copy over the existing values
+				m_Capacity = m_Capacity == 0 ? 16 : m_Capacity * 2;
+				TYPE* data = new TYPE[m_Capacity];
+				for (unsigned int i = 0; i < m_Size; i++)
+					data[i] = m_Data[i];
+				if (m_Data != 0)
+					delete [] m_Data;
+				m_Data = data;
+			}
+
+			m_Data[m_Size++] = value;
+		}
+
+		TYPE& operator [] (unsigned int index)
+		{
+			clcpp::internal::Assert(index < m_Size);
+			return m_Data[index];
+		}
+		const TYPE& operator [] (unsigned int index) const
+		{
+			clcpp::internal::Assert(index < m_Size);
+			return m_Data[index];
+		}
+
+		unsigned int GetSize() const { return m_Size; }
+
+		// Empties the array, keeping its storage
+		void Clear() { m_Size = 0; }
+
+	private:
+		// Disable copying
+		GrowArray(const GrowArray&);
+		GrowArray& operator= (const GrowArray&);
+
+		TYPE* m_Data;
+		unsigned int m_Size;
+		unsigned int m_Capacity;
+	};
+
+
+	// A chunk size to write over the placeholder at a position in the joined frames of a stream
+	struct SizeFixup
+	{
+		unsigned int position;
+		unsigned int size;
+	};
+
+
+	//
+	// Splits a streamed graph into frames, each written with its size and followed by the sizes
+	// of any chunks that started in an earlier frame, as that may already have been flushed.
+	// Only the open frame is pinned so a streaming WriteBuffer never holds more than about one
+	// frame of data, however large the graph. Positions are in the graph with frames joined.
+	//
+	struct FrameWriter
+	{
+		// Marks the end of the last frame
+		static const unsigned int END = 0xFFFFFFFF;
+
+		FrameWriter(clutl::WriteBuffer& out, unsigned int frame_size)
+			: out(out)
+			, frame_size(frame_size)
+			, frame_start(0)
+			, frame_position(0)
+		{
+			Open();
+		}
+
+		void Open()
+		{
+			frame_start = out.GetBytesWritten();
+			out.Pin();
+			unsigned int zero = 0;
+			out.Write(&zero, sizeof(zero));
+		}
+
+		void Close()
+		{
+			// Patch the size of the frame and follow it with its fixups
+			unsigned int size = GetFrameSize();
+			*(unsigned int*)out.GetDataAt(frame_start) = size;
+			frame_position += size;
+			unsigned int nb_fixups = fixups.GetSize();
+			out.Write(&nb_fixups, sizeof(nb_fixups));
+			for (unsigned int i = 0; i < nb_fixups; i++)
+				out.Write(&fixups[i], sizeof(SizeFixup));
+			fixups.Clear();
+			out.Unpin();
+		}
+
+		void Finish()
+		{
+			Close();
+			unsigned int end = END;
+			out.Write(&end, sizeof(end));
+		}
+
+		void Split()
+		{
+			// Called between writes to start a new frame once the open one is full
+			if (GetFrameSize() >= frame_size)
+			{
+				Close();
+				Open();
+			}
+		}
+
+		void PatchSize(unsigned int position, unsigned int size)
+		{
+			// Sizes in the open frame can be patched in memory
+			if (position >= frame_position)
+			{
+				*(unsigned int*)out.GetDataAt(frame_start + sizeof(unsigned int) + position - frame_position) = size;
+				return;
+			}
+
+			SizeFixup fixup = { position, size };
+			fixups.Add(fixup);
+		}
+
+		unsigned int GetFrameSize() const { return out.GetBytesWritten() - (frame_start + sizeof(unsigned int)); }
+		unsigned int GetPosition() const { return frame_position + GetFrameSize(); }
+
+		clutl::WriteBuffer& out;
+		unsigned int frame_size;
+
+		// Position of the open frame's size in the buffer and of its data in the joined frames
+		unsigned int frame_start;
+		unsigned int frame_position;
+
+		GrowArray<SizeFixup> fixups;
+	};
+
+
 	struct SizeBackPatcher
 	{
 		SizeBackPatcher()
 			: size_offset(0xFFFFFFFF)
+			, frames(0)
 		{
 		}
 
-		void Mark(clutl::WriteBuffer& out)
+		void Mark(clutl::WriteBuffer& out, FrameWriter* frame_writer = 0)
 		{
-			// Mark the location of the patch and write a dummy value
-			size_offset = out.GetBytesWritten();
+			// Streamed graphs leave the size to their frames, which may start a new frame first
+			frames = frame_writer;
+			if (frames != 0)
+			{
+				frames->Split();
+				size_offset = frames->GetPosition();
+			}
+
+			// Otherwise mark the location of the patch, keeping it in memory until patched
+			else
+			{
+				size_offset = out.GetBytesWritten();
+				out.Pin();
+			}
+
+			// Write a dummy value
 			unsigned int zero = 0;
 			out.Write(&zero, sizeof(zero));
 		}
@@ -65,10 +258,123 @@ namespace
 			if (size_offset == 0xFFFFFFFF)
 				return 0;
 
+			if (frames != 0)
+			{
+				unsigned int size = frames->GetPosition() - (size_offset + sizeof(unsigned int));
+				frames->PatchSize(size_offset, size);
+				frames->Split();
+				return size;
+			}
+
 			// Calculate size of the data written since the mark and write to the data size offset
 			unsigned int size = out.GetBytesWritten() - (size_offset + sizeof(unsigned int));
-			unsigned int* patch_size = (unsigned int*)(out.GetData() + size_offset);
+			unsigned int* patch_size = (unsigned int*)out.GetDataAt(size_offset);
 			*patch_size = size;
+			out.Unpin();
+			return size;
+		}
+
+		// Position of the size for back-patching
+		unsigned int size_offset;
+
+		// Frames of a streamed graph, patching the size instead
+		FrameWriter* frames;
+	};
+
+
+	unsigned int EncodeVarint(unsigned char* data, unsigned int value)
+	{
+		// Seven bits to a byte, lowest first, with the top bit set on all but the last byte
+		unsigned int size = 0;
+		while (value >= 0x80)
+		{
+			data[size++] = (unsigned char)(value | 0x80);
+			value >>= 7;
+		}
+		data[size++] = (unsigned char)value;
+		return size;
+	}
+
+
+	unsigned int GetVarintSize(unsigned int value)
+	{
+		unsigned int size = 1;
+		while (value >= 0x80)
+		{
+			value >>= 7;
+			size++;
+		}
+		return size;
+	}
+
+
+	void WriteVarint(clutl::WriteBuffer& out, unsigned int value)
+	{
+		unsigned char data[5];
+		out.Write(data, EncodeVarint(data, value));
+	}
+
+
+	unsigned int DecodeVarint(const char*& data, const char* end)
+	{
+		// Stop at the end of the data or after the most bytes a 32-bit value can take
+		unsigned int value = 0;
+		for (unsigned int shift = 0; data < end && shift < 35; shift += 7)
+		{
+			unsigned char c = *data++;
+			value |= (unsigned int)(c & 0x7F) << shift;
+			if ((c & 0x80) == 0)
+				break;
+		}
+		return value;
+	}
+
+
+	unsigned int ReadVarint(clutl::ReadBuffer& in)
+	{
+		const char* start = in.ReadAt(in.GetBytesRead());
+		const char* data = start;
+		unsigned int value = DecodeVarint(data, start + in.GetBytesRemaining());
+		in.SeekRel(data - start);
+		return value;
+	}
+
+
+	//
+	// Back-patches the size of the data written after it as a varint, reserving one byte for it
+	// and moving the data along in the less common case that it needs more
+	//
+	struct VarintSizePatcher
+	{
+		VarintSizePatcher()
+			: size_offset(0xFFFFFFFF)
+		{
+		}
+
+		void Mark(clutl::WriteBuffer& out)
+		{
+			size_offset = out.GetBytesWritten();
+			out.Pin();
+			out.Alloc(1);
+		}
+
+		unsigned int Patch(clutl::WriteBuffer& out)
+		{
+			if (size_offset == 0xFFFFFFFF)
+				return 0;
+
+			unsigned int data_offset = size_offset + 1;
+			unsigned int size = out.GetBytesWritten() - data_offset;
+			unsigned char varint[5];
+			unsigned int varint_size = EncodeVarint(varint, size);
+			if (varint_size > 1)
+			{
+				out.Alloc(varint_size - 1);
+				char* data = out.GetDataAt(data_offset);
+				memmove(data + varint_size - 1, data, size);
+			}
+			memcpy(out.GetDataAt(size_offset), varint, varint_size);
+			out.Unpin();
 			return size;
 		}
 
@@ -79,14 +385,14 @@ namespace
 
 	struct ChunkHeaderWriter
 	{
-		ChunkHeaderWriter(clutl::WriteBuffer& out, unsigned int type_hash, unsigned int name_hash)
+		ChunkHeaderWriter(clutl::WriteBuffer& out, unsigned int type_hash, unsigned int name_hash, FrameWriter* frames)
 			: out(out)
 			, header(type_hash, name_hash)
 		{
 			// Only commit the hashes and data size, marking the data size location for future patching
 			out.Write(&header.type_hash, sizeof(header.type_hash));
 			out.Write(&header.name_hash, sizeof(header.name_hash));
-			patcher.Mark(out);
+			patcher.Mark(out, frames);
 		}
 
 		~ChunkHeaderWriter()
@@ -102,17 +408,51 @@ namespace
 	};
 
 
+	unsigned int GetPtrTypeHash(const clcpp::Type* type)
+	{
+		// Pointers are saved with a different type hash to values of the same type so that changing
+		// a field between the two is caught at load time as a type mismatch
+		return clcpp::internal::HashData(&type->name.hash, sizeof(type->name.hash), 1);
+	}
+
+
+	unsigned int GetObjectTableHash()
+	{
+		static const unsigned int hash = CLCPP_NAME_HASH("clutl::ObjectTable");
+		return hash;
+	}
+
+
 	struct ContainerChunkHeader
 	{
-		ContainerChunkHeader(clutl::WriteBuffer& out, clcpp::ReadIterator& reader)
+		ContainerChunkHeader(clutl::WriteBuffer& out, clcpp::ReadIterator& reader, bool compact)
 			: count(reader.m_Count)
 			, value_type_hash(reader.m_ValueType->name.hash)
 			, value_type_size(0)
 		{
+			if (compact)
+			{
+				// Only values that can vary in size, such as classes and pointer references, are saved
+				// with their size. Enums are saved as the hash of their constant's name.
+				if (reader.m_ValueIsPtr)
+					value_type_hash = GetPtrTypeHash(reader.m_ValueType);
+				else if (reader.m_ValueType->kind == clcpp::Primitive::KIND_TYPE)
+					value_type_size = reader.m_ValueType->size;
+				else if (reader.m_ValueType->kind == clcpp::Primitive::KIND_ENUM)
+					value_type_size = sizeof(unsigned int);
+
+				// Counts and sizes are written as varints
+				WriteVarint(out, count);
+				out.Write(&value_type_hash, sizeof(value_type_hash));
+				WriteVarint(out, value_type_size);
+				return;
+			}
+
 			if (reader.m_ValueIsPtr)
 			{
-				// Pointers are fixed size
-				value_type_size = sizeof(void*);
+				// Pointers are saved as fixed size object references
+				value_type_hash = GetPtrTypeHash(reader.m_ValueType);
+				value_type_size = sizeof(unsigned int);
 			}
 			else if (reader.m_ValueType->kind == clcpp::Primitive::KIND_CLASS)
 			{
@@ -132,9 +472,16 @@ namespace
 			out.Write(&value_type_size, sizeof(value_type_size));
 		}
 
-		ContainerChunkHeader(clutl::ReadBuffer& in)
+		ContainerChunkHeader(clutl::ReadBuffer& in, bool compact)
 		{
 			// Read values for later use
+			if (compact)
+			{
+				count = ReadVarint(in);
+				in.Read(&value_type_hash, sizeof(value_type_hash));
+				value_type_size = ReadVarint(in);
+				return;
+			}
 			in.Read(&count, sizeof(count));
 			in.Read(&value_type_hash, sizeof(value_type_hash));
 			in.Read(&value_type_size, sizeof(value_type_size));
@@ -148,174 +495,1043 @@ namespace
 	};
 
 
-	void SaveObject(clutl::WriteBuffer& out, const char* object, const clcpp::Type* type);
-	void LoadObject(clutl::ReadBuffer& in, char* object, const clcpp::Type* type, unsigned int data_size, unsigned int type_hash);
-
-
-	void SaveType(clutl::WriteBuffer& out, const char* object, const clcpp::Type* type)
-	{
-		out.Write(object, type->size);
-	}
-
-	
-	void SaveEnum(clutl::WriteBuffer& out, const char* object, const clcpp::Enum* enum_type)
+	//
+	// Hash table from addresses to values, used to map each object saved in a graph to its reference,
+	// ensuring objects that are pointed to more than once are only saved once, and to map classes to
+	// their plans. Addresses can be paired with a type, as an object and its first field share the
+	// same address.
+	//
+	template <typename VALUE_TYPE>
+	class PtrMap
 	{
-		// Do a linear search for an enum with a matching value
-		// TODO: Optimise this to a binary search by storing sorted enum values?
-		//       They're currently sorted by name...
-		int value = *(int*)object;
-		clcpp::Name enum_name;
-		for (unsigned int i = 0; i < enum_type->constants.size; i++)
+	public:
+		PtrMap()
+			: m_MaxNbEntries(0)
+			, m_NbEntries(0)
+			, m_Entries(0)
 		{
-			if (enum_type->constants[i]->value == value)
-			{
-				enum_name = enum_type->constants[i]->name;
-				break;
-			}
 		}
 
-		// TODO: What if a match can't be found?
-
-		// Write the name's has as the value
-		out.Write(&enum_name.hash, sizeof(enum_name.hash));
-	}
-
-
-	void SaveContainer(clutl::WriteBuffer& out, clcpp::ReadIterator& reader)
-	{
-		// Add the container header
-		ContainerChunkHeader header(out, reader);
+		~PtrMap()
+		{
+			if (m_Entries != 0)
+				delete [] m_Entries;
+		}
 
-		for (unsigned int i = 0; i < reader.m_Count; i++)
+		// Returns zero if the address hasn't been added with the type
+		VALUE_TYPE Find(const void* ptr, const void* type = 0) const
 		{
-			clcpp::ContainerKeyValue kv = reader.GetKeyValue();
+			if (m_Entries == 0)
+				return 0;
 
-			// If this is a value that could have variable data written, store a size next to it
-			SizeBackPatcher patcher;
-			if (header.value_type_size == 0)
-				patcher.Mark(out);
+			// Linear probe from the natural hash location for the object or an empty slot
+			const unsigned int index_mask = m_MaxNbEntries - 1;
+			unsigned int index = Hash(ptr, type) & index_mask;
+			while (m_Entries[index].ptr != 0 && (m_Entries[index].ptr != ptr || m_Entries[index].type != type))
+				index = (index + 1) & index_mask;
 
-			if (reader.m_ValueIsPtr)
-			{
-				// Ask the user if they want to save this pointer
-				//void* ptr = *(void**)kv.value;
-				//if (ptr_save == 0 || !ptr_save->CanSavePtr(ptr, field, reader.m_ValueType))
-				//	continue;
+			return m_Entries[index].value;
+		}
 
-				//SavePtr(out, kv.value, ptr_save, flags);
-			}
-			else
+		void Add(const void* ptr, VALUE_TYPE value, const void* type = 0)
+		{
+			if (m_Entries == 0)
 			{
-				SaveObject(out, (char*)kv.value, reader.m_ValueType);
+				m_MaxNbEntries = 64;
+				m_Entries = new Entry[m_MaxNbEntries];
 			}
 
-			// Patch any accompanying sizes
-			patcher.Patch(out);
+			Insert(ptr, type, value);
 
-			reader.MoveNext();
+			// Resize when load factor is greater than 2/3
+			if (++m_NbEntries > (m_MaxNbEntries * 2) / 3)
+				Resize();
 		}
-	}
 
+	private:
+		// Disable copying
+		PtrMap(const PtrMap&);
+		PtrMap& operator= (const PtrMap&);
 
-	void SaveFieldArray(clutl::WriteBuffer& out, const char* object, const clcpp::Field* field)
-	{
-		// Construct a read iterator and serialise as container
-		clcpp::ReadIterator reader(field, object);
-		SaveContainer(out, reader);
-	}
+		struct Entry
+		{
+			Entry()
+				: ptr(0)
+				, type(0)
+				, value(0)
+			{
+			}
 
+			const void* ptr;
+			const void* type;
+			VALUE_TYPE value;
+		};
 
-	void SaveClassField(clutl::WriteBuffer& out, const char* object, const clcpp::Field* field)
-	{
-		if ((field->flag_attributes & clcpp::FlagAttribute::TRANSIENT) != 0)
-			return;
+		static unsigned int Hash(const void* ptr, const void* type)
+		{
+			// Discard the low bits of the addresses, which alignment leaves mostly zero, and mix the
+			// rest so that objects allocated close together spread across the table
+			unsigned int hash = (unsigned int)((clcpp::pointer_type)ptr >> 3);
+			hash ^= (unsigned int)((clcpp::pointer_type)type >> 3) * 0xCC9E2D51;
+			hash ^= hash >> 16;
+			hash *= 0x85EBCA6B;
+			hash ^= hash >> 13;
+			return hash;
+		}
 
-		ChunkHeaderWriter header_writer(out, field->type->name.hash, field->name.hash);
+		void Insert(const void* ptr, const void* type, VALUE_TYPE value)
+		{
+			// Linear probe from the natural hash location for an empty slot
+			const unsigned int index_mask = m_MaxNbEntries - 1;
+			unsigned int index = Hash(ptr, type) & index_mask;
+			while (m_Entries[index].ptr != 0)
+				index = (index + 1) & index_mask;
+
+			m_Entries[index].ptr = ptr;
+			m_Entries[index].type = type;
+			m_Entries[index].value = value;
+		}
 
-		// Is there a custom save function for this field?
-		// TODO: Flag for marking custom saves on a field
-		if (field->attributes.size != 0)
+		void Resize()
 		{
-			static unsigned int hash = clcpp::internal::HashNameString("save_vbin");			
-			if (const clcpp::Attribute* attr = clcpp::FindPrimitive(field->attributes, hash))
+			// Reinsert all entries into a table of twice the size
+			unsigned int old_max_nb_entries = m_MaxNbEntries;
+			Entry* old_entries = m_Entries;
+			m_MaxNbEntries *= 2;
+			m_Entries = new Entry[m_MaxNbEntries];
+			for (unsigned int i = 0; i < old_max_nb_entries; i++)
 			{
-				// Call the function to write data
-				const clcpp::PrimitiveAttribute* name_attr = attr->AsPrimitiveAttribute();
-				clcpp::CallFunction((clcpp::Function*)name_attr->primitive, clcpp::ByRef(out), object);
-				return;
+				if (old_entries[i].ptr != 0)
+					Insert(old_entries[i].ptr, old_entries[i].type, old_entries[i].value);
 			}
+
+			delete [] old_entries;
 		}
 
-		// ContainerInfos for fields can only be C-Arrays
-		if (field->ci != 0)
-			SaveFieldArray(out, object, field);
-		else
-			SaveObject(out, object, field->type);
-	}
+		unsigned int m_MaxNbEntries;
+		unsigned int m_NbEntries;
+		Entry* m_Entries;
+	};
 
 
-	void SaveClass(clutl::WriteBuffer& out, const char* object, const clcpp::Class* class_type)
+	//
+	// A field in a run of primitive value fields, along with the chunk header it's saved with
+	//
+	struct PlanSlot
 	{
-		// Save each field in the class
-		const clcpp::CArray<const clcpp::Field*>& fields = class_type->fields;
-		for (unsigned int i = 0; i < fields.size; i++)
+		PlanSlot()
+			: offset(0)
+			, index(0)
 		{
-			const clcpp::Field* field = fields[i];
-			const char* field_object = object + field->offset;
-			SaveClassField(out, field_object, field);
+			header[0] = header[1] = header[2] = 0;
 		}
-	}
 
+		// Type hash, name hash and data size
+		unsigned int header[3];
 
-	void SaveObject(clutl::WriteBuffer& out, const char* object, const clcpp::Type* type)
-	{
-		// Dispatch to a save function based on kind
-		switch (type->kind)
-		{
-		case (clcpp::Primitive::KIND_TYPE):
-			SaveType(out, object, type);
-			break;
+		unsigned int offset;
 
-		case (clcpp::Primitive::KIND_ENUM):
-			SaveEnum(out, object, type->AsEnum());
-			break;
+		// Index of the field in the class's field table in compact streams
+		unsigned int index;
+	};
 
-		case (clcpp::Primitive::KIND_CLASS):
-			SaveClass(out, object, type->AsClass());
-			break;
 
-		default:
-			clcpp::internal::Assert(false && "Invalid primitive kind for type");
+	//
+	// A single operation in a class plan, which either saves/loads a run of primitive value fields
+	// or one field that needs more work
+	//
+	struct PlanOp
+	{
+		enum Kind
+		{
+			KIND_RUN,
+			KIND_ARRAY,
+			KIND_PTR,
+			KIND_OBJECT,
+		};
+
+		PlanOp()
+			: kind(KIND_RUN)
+			, type_hash(0)
+			, field(0)
+			, save_function(0)
+			, load_function(0)
+			, first_slot(0)
+			, nb_slots(0)
+			, run_size(0)
+			, compact_run_size(0)
+			, index(0)
+			, fixed_size(0)
+		{
 		}
-	}
 
+		Kind kind;
 
-	void LoadType(clutl::ReadBuffer& in, char* object, const clcpp::Type* type, unsigned int data_size)
-	{
-		// Primitive data types must be the same size, for now. I guess this can only happen when sharing
-		// data files between platforms.
-		// TODO: Conversion of same-named data types of varying size?
-		if (type->size != data_size)
-			// TODO: Mark error
-			in.SeekRel(data_size);
-		else
-			in.Read(object, type->size);
-	}
+		// Type hash the field's chunk is saved with
+		unsigned int type_hash;
+
+		// The field for everything but runs, with any custom save/load functions it has
+		const clcpp::Field* field;
+		const clcpp::Function* save_function;
+		const clcpp::Function* load_function;
+
+		// The range of slots in a run and the total size of their headers and data, or of their indices
+		// and data in compact streams
+		unsigned int first_slot;
+		unsigned int nb_slots;
+		unsigned int run_size;
+		unsigned int compact_run_size;
+
+		// Index of the field in compact streams and the size of its data if that's always the same
+		unsigned int index;
+		unsigned int fixed_size;
+	};
 
 
-	void LoadEnum(clutl::ReadBuffer& in, char* object, const clcpp::Enum* enum_type, unsigned int data_size)
+	//
+	// A primitive value, enum or C-Array of them in the memory layout of a class, with the fields
+	// of value classes expanded in-place. Each is identified by a hash of its path of field names.
+	//
+	struct LayoutLeaf
 	{
-		// Enum data types must be the same size, for now
-		// I guess this is more possible than primitive data types as enum size can change between compiles
-		// TODO: Conversion of variable-sized enums
-		if (enum_type->size != data_size)
+		LayoutLeaf()
+			: path_hash(0)
+			, type_hash(0)
+			, offset(0)
+			, data_offset(0)
+			, size(0)
+			, count(0)
 		{
-			// TODO: Mark error
-			in.SeekRel(data_size);
-			return;
 		}
 
-		// Read the enum name hash and do a search for it in the constant list
+		unsigned int path_hash;
+		unsigned int type_hash;
+
+		// Offset within the object and within the raw data saved in a snapshot
+		unsigned int offset;
+		unsigned int data_offset;
+
+		// Size of each value and the number of values
+		unsigned int size;
+		unsigned int count;
+	};
+
+
+	//
+	// What to do with a chunk in data saved with an older class layout, found by looking its field up
+	// once and reused for every later object whose chunks have the same headers
+	//
+	struct SchemaStep
+	{
+		enum Action
+		{
+			// The field no longer exists, is transient or its type/size has changed
+			ACTION_SKIP,
+
+			// Primitive value of the same type and size, copied straight into the object
+			ACTION_COPY,
+
+			// Anything else is loaded as a field
+			ACTION_FIELD,
+		};
+
+		SchemaStep()
+			: match_size(false)
+			, action(ACTION_SKIP)
+			, offset(0)
+			, field(0)
+			, load_function(0)
+		{
+			header[0] = header[1] = header[2] = 0;
+		}
+
+		// Type hash, name hash and data size of the chunk, with the size only checked if the action
+		// depends on it
+		unsigned int header[3];
+		bool match_size;
+
+		Action action;
+		unsigned int offset;
+		const clcpp::Field* field;
+		const clcpp::Function* load_function;
+	};
+
+
+	// A contiguous range of memory within an object that's copied to/from snapshots in one go
+	struct RawRun
+	{
+		RawRun()
+			: offset(0)
+			, size(0)
+		{
+		}
+
+		unsigned int offset;
+		unsigned int size;
+	};
+
+
+	//
+	// The fields of a class compiled into a flat list of operations, in the order they're saved.
+	// Primitive value fields that follow each other are merged into runs that are saved with one
+	// allocation and loaded after one check of all their headers. Transient fields are left out
+	// and the search for custom functions is done up-front.
+	//
+	struct ClassPlan
+	{
+		ClassPlan()
+			: class_hash(0)
+			, is_raw(false)
+			, fingerprint(0)
+			, raw_size(0)
+			, saved_stream_id(0)
+			, loaded_stream_id(0)
+			, load_depth(0)
+		{
+		}
+
+		GrowArray<PlanOp> ops;
+		GrowArray<PlanSlot> slots;
+
+		// The type hash, name hash and fixed size (zero if it varies) of each field saved, in index order,
+		// for the field tables of compact streams
+		unsigned int class_hash;
+		GrowArray<PlanSlot> table_fields;
+
+		// Snapshots copy classes made from nothing but primitive values, enums and other such classes
+		// as raw runs of memory, identified by a fingerprint of their layout. The layout leaves of
+		// other classes are still recorded for loading snapshots from different builds.
+		bool is_raw;
+		unsigned int fingerprint;
+		unsigned int raw_size;
+		GrowArray<LayoutLeaf> leaves;
+		GrowArray<RawRun> runs;
+
+		// The last snapshot or compact stream this class was saved in, for recording its layout or field
+		// table once per stream
+		mutable unsigned int saved_stream_id;
+
+		// The last compact stream this class was loaded from and the steps for each index in its field table
+		mutable unsigned int loaded_stream_id;
+		mutable GrowArray<SchemaStep> stream_steps;
+
+		// The sequence of chunks last loaded for this class that didn't follow its plan, mapped to the
+		// fields they load into. Only the outermost load of a class replaces it, as nested loads of the
+		// same class may still be following it.
+		mutable GrowArray<SchemaStep> schema;
+		mutable unsigned int load_depth;
+	};
+}
+
+
+struct clutl::VBinPlans
+{
+	VBinPlans()
+		: nb_streams(0)
+	{
+	}
+
+	~VBinPlans()
+	{
+		for (unsigned int i = 0; i < plans.GetSize(); i++)
+			delete plans[i];
+	}
+
+	PtrMap<ClassPlan*> class_plans;
+	GrowArray<ClassPlan*> plans;
+
+	unsigned int nb_streams;
+};
+
+
+namespace
+{
+	const clcpp::Function* FindCustomFunction(const clcpp::Field* field, unsigned int attribute_hash)
+	{
+		// TODO: Flag for marking custom saves/loads on a field
+		if (field->attributes.size == 0)
+			return 0;
+		const clcpp::Attribute* attr = clcpp::FindPrimitive(field->attributes, attribute_hash);
+		if (attr == 0)
+			return 0;
+		return (const clcpp::Function*)attr->AsPrimitiveAttribute()->primitive;
+	}
+
+
+	ClassPlan* CompileClassPlan(const clcpp::Class* class_type)
+	{
+		static const unsigned int save_hash = CLCPP_NAME_HASH("save_vbin");
+		static const unsigned int load_hash = CLCPP_NAME_HASH("load_vbin");
+
+		ClassPlan* plan = new ClassPlan;
+		plan->class_hash = class_type->name.hash;
+		const clcpp::CArray<const clcpp::Field*>& fields = class_type->fields;
+		for (unsigned int i = 0; i < fields.size; i++)
+		{
+			const clcpp::Field* field = fields[i];
+			if ((field->flag_attributes & clcpp::FlagAttribute::TRANSIENT) != 0)
+				continue;
+
+			// Fields are indexed in the order they're saved
+			PlanSlot table_field;
+			table_field.header[1] = field->name.hash;
+			table_field.index = plan->table_fields.GetSize();
+
+			PlanOp op;
+			op.type_hash = field->type->name.hash;
+			op.index = table_field.index;
+			op.field = field;
+			op.save_function = FindCustomFunction(field, save_hash);
+			op.load_function = FindCustomFunction(field, load_hash);
+
+			// ContainerInfos for fields can only be C-Arrays
+			if (field->ci != 0)
+				op.kind = PlanOp::KIND_ARRAY;
+			else if (field->qualifier.op == clcpp::Qualifier::POINTER)
+			{
+				op.kind = PlanOp::KIND_PTR;
+				op.type_hash = GetPtrTypeHash(field->type);
+			}
+			else if (field->type->kind != clcpp::Primitive::KIND_TYPE || op.save_function != 0 || op.load_function != 0)
+				op.kind = PlanOp::KIND_OBJECT;
+
+			else
+			{
+				// Start a new run if the previous operation isn't one
+				unsigned int nb_ops = plan->ops.GetSize();
+				if (nb_ops == 0 || plan->ops[nb_ops - 1].kind != PlanOp::KIND_RUN)
+				{
+					PlanOp run_op;
+					run_op.first_slot = plan->slots.GetSize();
+					plan->ops.Add(run_op);
+					nb_ops++;
+				}
+
+				PlanSlot slot = table_field;
+				slot.header[0] = field->type->name.hash;
+				slot.header[2] = field->type->size;
+				slot.offset = field->offset;
+				plan->slots.Add(slot);
+				plan->table_fields.Add(slot);
+
+				PlanOp& run_op = plan->ops[nb_ops - 1];
+				run_op.nb_slots++;
+				run_op.run_size += sizeof(slot.header) + field->type->size;
+				run_op.compact_run_size += GetVarintSize(slot.index) + field->type->size;
+				continue;
+			}
+
+			// Enums without custom functions are always saved as the hash of their constant's name
+			if (op.kind == PlanOp::KIND_OBJECT && field->type->kind == clcpp::Primitive::KIND_ENUM &&
+				op.save_function == 0 && op.load_function == 0)
+				op.fixed_size = sizeof(unsigned int);
+
+			table_field.header[0] = op.type_hash;
+			table_field.header[2] = op.fixed_size;
+			plan->table_fields.Add(table_field);
+			plan->ops.Add(op);
+		}
+
+		return plan;
+	}
+
+
+	void CompileLayout(clutl::VBinPlans& plans, const clcpp::Class* class_type, ClassPlan* plan);
+
+
+	const ClassPlan* GetClassPlan(clutl::VBinPlans& plans, const clcpp::Class* class_type)
+	{
+		// Compile plans on first use
+		ClassPlan* plan = plans.class_plans.Find(class_type);
+		if (plan == 0)
+		{
+			plan = CompileClassPlan(class_type);
+			plans.class_plans.Add(class_type, plan);
+			plans.plans.Add(plan);
+			CompileLayout(plans, class_type, plan);
+		}
+		return plan;
+	}
+
+
+	void AddLayoutLeaf(ClassPlan* plan, bool join, unsigned int path_hash, unsigned int type_hash, unsigned int offset, unsigned int size, unsigned int count)
+	{
+		// Merge with the last run if it reaches this value, or start a new one. Runs aren't joined across
+		// padding as its bytes may be uninitialised.
+		unsigned int nb_runs = plan->runs.GetSize();
+		if (!join || nb_runs == 0 || offset < plan->runs[nb_runs - 1].offset ||
+			offset > plan->runs[nb_runs - 1].offset + plan->runs[nb_runs - 1].size)
+		{
+			RawRun run;
+			run.offset = offset;
+			plan->runs.Add(run);
+			nb_runs++;
+		}
+		RawRun& run = plan->runs[nb_runs - 1];
+
+		LayoutLeaf leaf;
+		leaf.path_hash = path_hash;
+		leaf.type_hash = type_hash;
+		leaf.offset = offset;
+		leaf.data_offset = plan->raw_size + offset - (run.offset + run.size);
+		leaf.size = size;
+		leaf.count = count;
+		plan->leaves.Add(leaf);
+
+		// Extend the run, which may already cover values that share memory
+		unsigned int end = offset + size * count;
+		if (end > run.offset + run.size)
+		{
+			plan->raw_size += end - (run.offset + run.size);
+			run.size = end - run.offset;
+		}
+	}
+
+
+	void CompileLayout(clutl::VBinPlans& plans, const clcpp::Class* class_type, ClassPlan* plan)
+	{
+		static const unsigned int save_hash = CLCPP_NAME_HASH("save_vbin");
+		static const unsigned int load_hash = CLCPP_NAME_HASH("load_vbin");
+
+		// Classes that inherit from containers can't be flattened
+		bool is_raw = class_type->flattened_fields.size != 0 || class_type->base_types.size == 0;
+
+		// Runs can only be joined when no skipped field lies between them
+		bool join = false;
+
+		const clcpp::CArray<const clcpp::Field*>& fields = class_type->flattened_fields;
+		for (unsigned int i = 0; i < fields.size; i++)
+		{
+			const clcpp::Field* field = fields[i];
+			if ((field->flag_attributes & clcpp::FlagAttribute::TRANSIENT) != 0)
+			{
+				join = false;
+				continue;
+			}
+
+			// Anything that needs more than a copy of its memory stops the class being raw
+			if (field->qualifier.op == clcpp::Qualifier::POINTER ||
+				FindCustomFunction(field, save_hash) != 0 || FindCustomFunction(field, load_hash) != 0)
+			{
+				is_raw = join = false;
+				continue;
+			}
+
+			const clcpp::Type* type = field->type;
+			unsigned int count = field->ci != 0 ? field->ci->count : 1;
+			switch (type->kind)
+			{
+			case (clcpp::Primitive::KIND_TYPE):
+			case (clcpp::Primitive::KIND_ENUM):
+				AddLayoutLeaf(plan, join, field->name.hash, type->name.hash, field->offset, type->size, count);
+				join = true;
+				break;
+
+			case (clcpp::Primitive::KIND_CLASS):
+			{
+				const ClassPlan* field_plan = GetClassPlan(plans, type->AsClass());
+				const GrowArray<LayoutLeaf>& leaves = field_plan->leaves;
+				if (count == 1)
+				{
+					// Expand the layout of the field's class in-place, keeping the breaks between its runs
+					for (unsigned int j = 0; j < leaves.GetSize(); j++)
+					{
+						const LayoutLeaf& leaf = leaves[j];
+						if (j == 0)
+							join &= leaf.offset == 0;
+						else
+							join = leaf.data_offset - leaves[j - 1].data_offset == leaf.offset - leaves[j - 1].offset;
+						unsigned int path_hash = clcpp::internal::HashData(&leaf.path_hash, sizeof(leaf.path_hash), field->name.hash);
+						AddLayoutLeaf(plan, join, path_hash, leaf.type_hash, field->offset + leaf.offset, leaf.size, leaf.count);
+					}
+
+					// Anything following can only join if the last run reaches the end of the class
+					unsigned int nb_runs = field_plan->runs.GetSize();
+					join = nb_runs != 0 && field_plan->runs[nb_runs - 1].offset + field_plan->runs[nb_runs - 1].size == type->size;
+					is_raw &= field_plan->is_raw;
+				}
+
+				// Arrays of classes with no gaps in their layout can be copied as one value, identified
+				// by the layout of their class
+				else if (field_plan->is_raw && field_plan->runs.GetSize() == 1 &&
+					field_plan->runs[0].offset == 0 && field_plan->runs[0].size == type->size)
+				{
+					AddLayoutLeaf(plan, join, field->name.hash, field_plan->fingerprint, field->offset, type->size, count);
+					join = true;
+				}
+
+				else
+				{
+					is_raw = join = false;
+				}
+				break;
+			}
+
+			default:
+				is_raw = join = false;
+			}
+		}
+
+		// Hash the class name and layout into a fingerprint that changes if any value in the layout does
+		unsigned int fingerprint = class_type->name.hash;
+		for (unsigned int i = 0; i < plan->leaves.GetSize(); i++)
+		{
+			const LayoutLeaf& leaf = plan->leaves[i];
+			unsigned int values[] = { leaf.path_hash, leaf.type_hash, leaf.offset, leaf.size, leaf.count };
+			fingerprint = clcpp::internal::HashData(values, sizeof(values), fingerprint);
+		}
+
+		// Zero is reserved for classes that aren't raw
+		plan->is_raw = is_raw;
+		plan->fingerprint = fingerprint != 0 ? fingerprint : 1;
+	}
+
+
+	// An object in a graph being saved, along with the type it's saved as
+	struct PtrObject
+	{
+		PtrObject()
+			: ptr(0)
+			, type(0)
+		{
+		}
+
+		PtrObject(const void* ptr, const clcpp::Type* type)
+			: ptr(ptr)
+			, type(type)
+		{
+		}
+
+		const void* ptr;
+		const clcpp::Type* type;
+	};
+
+
+	// The encodings objects can be saved with
+	enum StreamFormat
+	{
+		FORMAT_VBIN,
+		FORMAT_COMPACT,
+		FORMAT_SNAPSHOT,
+	};
+
+
+	struct SaveContext
+	{
+		SaveContext(clutl::IPtrSave* ptr_save, clutl::VBinPlans& plans, StreamFormat format)
+			: ptr_save(ptr_save)
+			, plans(plans)
+			, format(format)
+			, stream_id(format != FORMAT_VBIN ? ++plans.nb_streams : 0)
+			, frames(0)
+		{
+		}
+
+		clutl::IPtrSave* ptr_save;
+		clutl::VBinPlans& plans;
+
+		// Snapshots and compact streams are numbered from one and record the plan of each class they
+		// save a layout or field table for, in the order they're first saved
+		StreamFormat format;
+		unsigned int stream_id;
+		GrowArray<const ClassPlan*> stream_plans;
+
+		// Every object in the graph in the order they were first referenced, starting with the object
+		// being saved. Pointers are saved as their object's reference, which is its index plus one,
+		// leaving zero as the null reference.
+		GrowArray<PtrObject> objects;
+		PtrMap<unsigned int> object_refs;
+
+		// Frames that streamed graphs are split into, leaving chunk sizes to them
+		FrameWriter* frames;
+	};
+
+
+	// A loaded pointer waiting for the object it references to be created
+	struct PtrPatch
+	{
+		PtrPatch()
+			: ptr(0)
+			, ref(0)
+		{
+		}
+
+		PtrPatch(void** ptr, unsigned int ref)
+			: ptr(ptr)
+			, ref(ref)
+		{
+		}
+
+		void** ptr;
+		unsigned int ref;
+	};
+
+
+	struct LoadContext
+	{
+		LoadContext(clutl::IPtrLoad* ptr_load, clutl::VBinPlans& plans, StreamFormat format)
+			: ptr_load(ptr_load)
+			, plans(plans)
+			, format(format)
+			, stream_id(format == FORMAT_COMPACT ? ++plans.nb_streams : 0)
+			, table(0)
+			, table_size(0)
+		{
+		}
+
+		clutl::IPtrLoad* ptr_load;
+		clutl::VBinPlans& plans;
+
+		// The table of class layouts at the end of a snapshot, or of field tables at the end of a
+		// compact stream
+		StreamFormat format;
+		unsigned int stream_id;
+		const char* table;
+		unsigned int table_size;
+
+		// Objects created for each reference and the pointers to patch once they all exist
+		GrowArray<void*> objects;
+		GrowArray<PtrPatch> patches;
+	};
+
+
+	void SaveObject(clutl::WriteBuffer& out, const char* object, const clcpp::Type* type, SaveContext& ctx);
+	void LoadObject(clutl::ReadBuffer& in, char* object, const clcpp::Type* type, unsigned int data_size, unsigned int type_hash, LoadContext& ctx);
+
+
+	void SaveType(clutl::WriteBuffer& out, const char* object, const clcpp::Type* type)
+	{
+		out.Write(object, type->size);
+	}
+
+	
+	void SaveEnum(clutl::WriteBuffer& out, const char* object, const clcpp::Enum* enum_type)
+	{
+		// Search for an enum with a matching value
+		int value = *(int*)object;
+		clcpp::Name enum_name;
+		if (const clcpp::EnumConstant* constant = enum_type->FindConstantByValue(value))
+			enum_name = constant->name;
+
+		// TODO: What if a match can't be found?
+
+		// Write the name's has as the value
+		out.Write(&enum_name.hash, sizeof(enum_name.hash));
+	}
+
+
+	void SavePtr(clutl::WriteBuffer& out, const void* ptr, const clcpp::Type* type, SaveContext& ctx)
+	{
+		// Pointers to types that can't be saved are written as null references
+		unsigned int ref = 0;
+		if (ptr != 0 && type->kind != clcpp::Primitive::KIND_TEMPLATE_TYPE)
+		{
+			// Objects know their own type, which may be derived from the pointer type
+			if (type->kind == clcpp::Primitive::KIND_CLASS &&
+				(type->AsClass()->flag_attributes & clobj::FLAG_ATTR_IS_OBJECT) != 0 &&
+				((const clobj::Object*)ptr)->type != 0)
+				type = ((const clobj::Object*)ptr)->type;
+
+			// Objects are identified by their type as well as their address, so that pointers to an
+			// object and to its first field are saved as different objects
+			ref = ctx.object_refs.Find(ptr, type);
+			if (ref == 0)
+			{
+				// First reference to this object so add it to the end of the object table
+				ctx.objects.Add(PtrObject(ptr, type));
+				ref = ctx.objects.GetSize();
+				ctx.object_refs.Add(ptr, ref, type);
+			}
+		}
+
+		if (ctx.format == FORMAT_COMPACT)
+			WriteVarint(out, ref);
+		else
+			out.Write(&ref, sizeof(ref));
+	}
+
+
+
+	void SaveContainer(clutl::WriteBuffer& out, clcpp::ReadIterator& reader, const clcpp::Field* field, SaveContext& ctx)
+	{
+		// Add the container header
+		ContainerChunkHeader header(out, reader, ctx.format == FORMAT_COMPACT);
+
+		// Primitive values stored contiguously can be written in one go
+		const void* values;
+		unsigned int count;
+		if (reader.m_Count != 0 && !reader.m_ValueIsPtr && reader.m_ValueType->kind == clcpp::Primitive::KIND_TYPE &&
+			reader.GetContiguous(values, count) && count == reader.m_Count)
+		{
+			out.Write(values, count * reader.m_ValueType->size);
+			return;
+		}
+
+		for (unsigned int i = 0; i < reader.m_Count; i++)
+		{
+			clcpp::ContainerKeyValue kv = reader.GetKeyValue();
+
+			// If this is a value that could have variable data written, store a size next to it
+			SizeBackPatcher patcher;
+			VarintSizePatcher varint_patcher;
+			if (header.value_type_size == 0)
+			{
+				if (ctx.format == FORMAT_COMPACT)
+					varint_patcher.Mark(out);
+				else
+					patcher.Mark(out, ctx.frames);
+			}
+
+			if (reader.m_ValueIsPtr)
+			{
+				// Ask the user if they want to save this pointer, keeping its place with a null reference if not
+				void* ptr = *(void**)kv.value;
+				if (ctx.ptr_save == 0 || !ctx.ptr_save->CanSavePtr(ptr, field, reader.m_ValueType))
+					ptr = 0;
+
+				SavePtr(out, ptr, reader.m_ValueType, ctx);
+			}
+			else
+			{
+				SaveObject(out, (char*)kv.value, reader.m_ValueType, ctx);
+			}
+
+			// Patch any accompanying sizes
+			patcher.Patch(out);
+			varint_patcher.Patch(out);
+
+			reader.MoveNext();
+		}
+	}
+
+
+	void SaveFieldArray(clutl::WriteBuffer& out, const char* object, const clcpp::Field* field, SaveContext& ctx)
+	{
+		// Construct a read iterator and serialise as container
+		clcpp::ReadIterator reader(field, object);
+		SaveContainer(out, reader, field, ctx);
+	}
+
+
+	void SaveRun(clutl::WriteBuffer& out, const char* object, const ClassPlan* plan, const PlanOp& op)
+	{
+		// Write the precomputed header and data of each field into space allocated for the whole run
+		char* data = (char*)out.Alloc(op.run_size);
+		for (unsigned int i = 0; i < op.nb_slots; i++)
+		{
+			const PlanSlot& slot = plan->slots[op.first_slot + i];
+			memcpy(data, slot.header, sizeof(slot.header));
+			data += sizeof(slot.header);
+			memcpy(data, object + slot.offset, slot.header[2]);
+			data += slot.header[2];
+		}
+	}
+
+
+	void SaveCompactRun(clutl::WriteBuffer& out, const char* object, const ClassPlan* plan, const PlanOp& op)
+	{
+		// Write the index and data of each field into space allocated for the whole run
+		unsigned char* data = (unsigned char*)out.Alloc(op.compact_run_size);
+		for (unsigned int i = 0; i < op.nb_slots; i++)
+		{
+			const PlanSlot& slot = plan->slots[op.first_slot + i];
+			data += EncodeVarint(data, slot.index);
+			memcpy(data, object + slot.offset, slot.header[2]);
+			data += slot.header[2];
+		}
+	}
+
+
+	void SaveFieldData(clutl::WriteBuffer& out, const char* object, const PlanOp& op, SaveContext& ctx)
+	{
+		// Call any custom function to write data
+		if (op.save_function != 0)
+		{
+			clcpp::CallFunction(op.save_function, clcpp::ByRef(out), object);
+			return;
+		}
+
+		if (op.kind == PlanOp::KIND_ARRAY)
+			SaveFieldArray(out, object, op.field, ctx);
+		else if (op.kind == PlanOp::KIND_PTR)
+			SavePtr(out, *(void**)object, op.field->type, ctx);
+		else
+			SaveObject(out, object, op.field->type, ctx);
+	}
+
+
+	void SaveClassField(clutl::WriteBuffer& out, const char* object, const PlanOp& op, SaveContext& ctx)
+	{
+		// Ask the user if they want to save this pointer
+		const clcpp::Field* field = op.field;
+		if (op.kind == PlanOp::KIND_PTR && (ctx.ptr_save == 0 || !ctx.ptr_save->CanSavePtr(*(void**)object, field, field->type)))
+			return;
+
+		// Compact streams write the index of the field, only followed by the size of its data if that varies
+		if (ctx.format == FORMAT_COMPACT)
+		{
+			WriteVarint(out, op.index);
+			VarintSizePatcher patcher;
+			if (op.fixed_size == 0)
+				patcher.Mark(out);
+			SaveFieldData(out, object, op, ctx);
+			patcher.Patch(out);
+		}
+		else
+		{
+			ChunkHeaderWriter header_writer(out, op.type_hash, field->name.hash, ctx.frames);
+			SaveFieldData(out, object, op, ctx);
+		}
+	}
+
+
+	void AddStreamPlan(const ClassPlan* plan, SaveContext& ctx)
+	{
+		// Record each plan once per stream, for the table written after it
+		if (plan->saved_stream_id != ctx.stream_id)
+		{
+			plan->saved_stream_id = ctx.stream_id;
+			ctx.stream_plans.Add(plan);
+		}
+	}
+
+
+	void SaveRawClass(clutl::WriteBuffer& out, const char* object, const ClassPlan* plan, SaveContext& ctx)
+	{
+		// Record the layout so that builds where it's changed can still find each value
+		AddStreamPlan(plan, ctx);
+
+		// Copy each run of memory into space allocated for all of them
+		char* data = (char*)out.Alloc(plan->raw_size);
+		for (unsigned int i = 0; i < plan->runs.GetSize(); i++)
+		{
+			const RawRun& run = plan->runs[i];
+			memcpy(data, object + run.offset, run.size);
+			data += run.size;
+		}
+	}
+
+
+	void SaveClass(clutl::WriteBuffer& out, const char* object, const clcpp::Class* class_type, SaveContext& ctx)
+	{
+		const ClassPlan* plan = GetClassPlan(ctx.plans, class_type);
+
+		// Snapshots lead with the fingerprint of the class layout if it's saved raw, or zero if not
+		if (ctx.format == FORMAT_SNAPSHOT)
+		{
+			unsigned int fingerprint = plan->is_raw ? plan->fingerprint : 0;
+			out.Write(&fingerprint, sizeof(fingerprint));
+			if (plan->is_raw)
+			{
+				SaveRawClass(out, object, plan, ctx);
+				return;
+			}
+		}
+
+		// Compact streams are followed by the field table of each class they save
+		bool compact = ctx.format == FORMAT_COMPACT;
+		if (compact)
+			AddStreamPlan(plan, ctx);
+
+		// Save each field in the class by following its plan
+		for (unsigned int i = 0; i < plan->ops.GetSize(); i++)
+		{
+			const PlanOp& op = plan->ops[i];
+			if (op.kind != PlanOp::KIND_RUN)
+				SaveClassField(out, object + op.field->offset, op, ctx);
+			else if (compact)
+				SaveCompactRun(out, object, plan, op);
+			else
+				SaveRun(out, object, plan, op);
+		}
+	}
+
+
+	void SaveObject(clutl::WriteBuffer& out, const char* object, const clcpp::Type* type, SaveContext& ctx)
+	{
+		// Dispatch to a save function based on kind
+		switch (type->kind)
+		{
+		case (clcpp::Primitive::KIND_TYPE):
+			SaveType(out, object, type);
+			break;
+
+		case (clcpp::Primitive::KIND_ENUM):
+			SaveEnum(out, object, type->AsEnum());
+			break;
+
+		case (clcpp::Primitive::KIND_CLASS):
+			SaveClass(out, object, type->AsClass(), ctx);
+			break;
+
+		default:
+			clcpp::internal::Assert(false && "Invalid primitive kind for type");
+		}
+	}
+
+
+	void SaveCompactObject(clutl::WriteBuffer& out, PtrObject object, SaveContext& ctx)
+	{
+		// Objects in compact streams are written with their type hash and size
+		out.Write(&object.type->name.hash, sizeof(object.type->name.hash));
+		VarintSizePatcher patcher;
+		patcher.Mark(out);
+		SaveObject(out, (const char*)object.ptr, object.type, ctx);
+		patcher.Patch(out);
+	}
+
+
+	void SaveObjectTable(clutl::WriteBuffer& out, SaveContext& ctx)
+	{
+		// Nothing to save if no pointers were followed from the object
+		if (ctx.objects.GetSize() <= 1)
+			return;
+
+		// Compact streams write each object after the last, without a chunk to contain them
+		if (ctx.format == FORMAT_COMPACT)
+		{
+			for (unsigned int i = 1; i < ctx.objects.GetSize(); i++)
+				SaveCompactObject(out, ctx.objects[i], ctx);
+			return;
+		}
+
+		// Saving each object can reference new objects, which are added to the end of the table
+		ChunkHeaderWriter header_writer(out, GetObjectTableHash(), 0, ctx.frames);
+		for (unsigned int i = 1; i < ctx.objects.GetSize(); i++)
+		{
+			PtrObject object = ctx.objects[i];
+			ChunkHeaderWriter object_header_writer(out, object.type->name.hash, 0, ctx.frames);
+			SaveObject(out, (const char*)object.ptr, object.type, ctx);
+		}
+	}
+
+
+	void LoadType(clutl::ReadBuffer& in, char* object, const clcpp::Type* type, unsigned int data_size)
+	{
+		// Primitive data types must be the same size, for now. I guess this can only happen when sharing
+		// data files between platforms.
+		// TODO: Conversion of same-named data types of varying size?
+		if (type->size != data_size)
+			// TODO: Mark error
+			in.SeekRel(data_size);
+		else
+			in.Read(object, type->size);
+	}
+
+
+	void LoadEnum(clutl::ReadBuffer& in, char* object, const clcpp::Enum* enum_type, unsigned int data_size)
+	{
+		// Enum data types must be the same size, for now
+		// I guess this is more possible than primitive data types as enum size can change between compiles
+		// TODO: Conversion of variable-sized enums
+		if (enum_type->size != data_size)
+		{
+			// TODO: Mark error
+			in.SeekRel(data_size);
+			return;
+		}
+
+		// Read the enum name hash and do a search for it in the constant list
 		unsigned int enum_name_hash;
 		in.Read(&enum_name_hash, sizeof(enum_name_hash));
 		const clcpp::EnumConstant* constant = clcpp::FindPrimitive(enum_type->constants, enum_name_hash);
@@ -326,153 +1542,587 @@ namespace
 	}
 
 
-	void LoadContainer(clutl::ReadBuffer& in, clcpp::WriteIterator& writer, unsigned int data_size, unsigned int expected_count)
+	void LoadPtr(clutl::ReadBuffer& in, void** object, LoadContext& ctx)
+	{
+		// Null references can be written immediately, leaving the rest to be patched once all
+		// objects in the graph have been created
+		unsigned int ref;
+		if (ctx.format == FORMAT_COMPACT)
+			ref = ReadVarint(in);
+		else
+			in.Read(&ref, sizeof(ref));
+		if (ref == 0)
+			*object = 0;
+		else
+			ctx.patches.Add(PtrPatch(object, ref));
+	}
+
+
+	bool IsRefSize(unsigned int data_size, const LoadContext& ctx)
+	{
+		// References are varints in compact streams
+		if (ctx.format == FORMAT_COMPACT)
+			return data_size != 0 && data_size <= 5;
+		return data_size == sizeof(unsigned int);
+	}
+
+
+	void LoadContainer(clutl::ReadBuffer& in, clcpp::WriteIterator& writer, unsigned int data_size, unsigned int expected_count, LoadContext& ctx)
+	{
+		unsigned int end_pos = in.GetBytesRead() + data_size;
+
+		ContainerChunkHeader header(in, ctx.format == FORMAT_COMPACT);
+
+		// Check array ranges
+		unsigned int count = header.count;
+		if (expected_count > count)
+		{
+			// This is fine, there's less data to load than storage space available
+			// TODO: Warning?
+		}
+		else if (expected_count < count)
+		{
+			// This is not fine, there's more data to load than storage space available
+			// Load as much as possible
+			// TODO: Warning
+			count = expected_count;
+		}
+
+		// Ensure value types match
+		unsigned int value_type_hash = writer.m_ValueIsPtr ? GetPtrTypeHash(writer.m_ValueType) : writer.m_ValueType->name.hash;
+		if (header.value_type_hash != value_type_hash)
+		{
+			// TODO: Warning
+			in.SeekRel(end_pos - in.GetBytesRead());
+			return;
+		}
+
+		// Primitive values of the same size can be read straight into contiguous storage
+		unsigned int nb_loaded = 0;
+		if (count != 0 && !writer.m_ValueIsPtr && writer.m_ValueType->kind == clcpp::Primitive::KIND_TYPE && header.value_type_size == writer.m_ValueType->size)
+		{
+			if (void* values = writer.AddEmptyContiguous(count))
+			{
+				in.Read(values, count * header.value_type_size);
+				nb_loaded = count;
+			}
+		}
+
+		for (unsigned int i = nb_loaded; i < count; i++)
+		{
+			char* container_object = (char*)writer.AddEmpty();
+
+			// Check to see if this is a value type that may be variable size
+			unsigned int value_type_size = header.value_type_size;
+			if (value_type_size == 0)
+			{
+				if (ctx.format == FORMAT_COMPACT)
+					value_type_size = ReadVarint(in);
+				else
+					in.Read(&value_type_size, sizeof(value_type_size));
+			}
+
+			if (writer.m_ValueIsPtr)
+			{
+				// Leave pointers untouched if the user doesn't want them
+				if (ctx.ptr_load != 0 && IsRefSize(value_type_size, ctx))
+					LoadPtr(in, (void**)container_object, ctx);
+				else
+					in.SeekRel(value_type_size);
+			}
+			else
+			{
+				LoadObject(in, container_object, writer.m_ValueType, value_type_size, header.value_type_hash, ctx);
+			}
+		}
+
+		int bytes_left = end_pos - in.GetBytesRead();
+		if (bytes_left > 0)
+		{
+			if (header.count != count)
+			{
+				// Skip over remaining data for when expected_count < count
+				in.SeekRel(bytes_left);
+			}
+
+			else
+			{
+				// ERROR: Lower levels should catch and correct underflow
+				// Assert?
+			}
+		}
+		else if (bytes_left < 0)
+		{
+			// ERROR: Lower levels should catch and correct overflow
+			// Assert?
+		}
+	}
+
+
+	void LoadFieldArray(clutl::ReadBuffer& in, char* object, const clcpp::Field* field, unsigned int data_size, LoadContext& ctx)
+	{
+		// Create an array write iterator
+		clcpp::WriteIterator writer;
+		writer.Initialise(field, object);
+		LoadContainer(in, writer, data_size, field->ci->count, ctx);
+	}
+
+
+	void LoadClassField(clutl::ReadBuffer& in, char* field_object, const clcpp::Field* field, const clcpp::Function* load_function, const ChunkHeader& header, LoadContext& ctx)
+	{
+		// Is there a custom load function for this field?
+		if (load_function != 0)
+		{
+			int end_pos = in.GetBytesRead() + header.data_size;
+
+			// Call the function to read the data
+			clcpp::CallFunction(load_function, clcpp::ByRef(in), field_object);
+
+			// Correct any read errors in the custom function
+			int position = in.GetBytesRead();
+			if (position < end_pos)
+			{
+				// TODO: Warning, not enough data read by custom reader
+				in.SeekRel(end_pos - position);
+			}
+			else if (position > end_pos)
+			{
+				// TODO: Warning, too much data read by custom reader
+				in.SeekRel(end_pos - position);
+			}
+
+			return;
+		}
+
+		if (field->ci != 0)
+		{
+			// TODO: What happens if counts differ?
+			LoadFieldArray(in, field_object, field, header.data_size, ctx);
+		}
+		else if (field->qualifier.op == clcpp::Qualifier::POINTER)
+		{
+			// Skip pointers the user doesn't want or that were saved as something else
+			if (ctx.ptr_load == 0 || header.type_hash != GetPtrTypeHash(field->type) || !IsRefSize(header.data_size, ctx))
+				in.SeekRel(header.data_size);
+			else
+				LoadPtr(in, (void**)field_object, ctx);
+		}
+		else
+		{
+			LoadObject(in, field_object, field->type, header.data_size, header.type_hash, ctx);
+		}
+	}
+
+
+	bool LoadRun(clutl::ReadBuffer& in, char* object, const ClassPlan* plan, const PlanOp& op, unsigned int end_pos)
+	{
+		// Check the whole run was saved with the same headers before loading any of it
+		if (in.GetBytesRead() + op.run_size > end_pos)
+			return false;
+		const char* data = in.ReadAt(in.GetBytesRead());
+		const char* run_data = data;
+		for (unsigned int i = 0; i < op.nb_slots; i++)
+		{
+			const PlanSlot& slot = plan->slots[op.first_slot + i];
+			unsigned int header[3];
+			memcpy(header, run_data, sizeof(header));
+			if (header[0] != slot.header[0] || header[1] != slot.header[1] || header[2] != slot.header[2])
+				return false;
+			run_data += sizeof(header) + slot.header[2];
+		}
+
+		// Copy the data of each field out from between the headers
+		for (unsigned int i = 0; i < op.nb_slots; i++)
+		{
+			const PlanSlot& slot = plan->slots[op.first_slot + i];
+			data += sizeof(slot.header);
+			memcpy(object + slot.offset, data, slot.header[2]);
+			data += slot.header[2];
+		}
+
+		in.SeekRel(op.run_size);
+		return true;
+	}
+
+
+	bool LoadPlanField(clutl::ReadBuffer& in, char* object, const PlanOp& op, unsigned int end_pos, LoadContext& ctx)
+	{
+		// Peek at the type and name of the next chunk to see if it belongs to this field
+		const unsigned int header_size = sizeof(unsigned int) * 3;
+		if (in.GetBytesRead() + header_size > end_pos)
+			return false;
+		unsigned int hashes[2];
+		memcpy(hashes, in.ReadAt(in.GetBytesRead()), sizeof(hashes));
+		if (hashes[0] != op.type_hash || hashes[1] != op.field->name.hash)
+			return false;
+
+		ChunkHeader header(in);
+		LoadClassField(in, object + op.field->offset, op.field, op.load_function, header, ctx);
+		return true;
+	}
+
+
+	SchemaStep MapChunk(const unsigned int* header, const clcpp::Class* class_type)
+	{
+		static const unsigned int load_hash = CLCPP_NAME_HASH("load_vbin");
+
+		// Skip the chunk if the field doesn't exist or its destination is transient
+		SchemaStep step;
+		memcpy(step.header, header, sizeof(step.header));
+		const clcpp::Field* field = clcpp::FindPrimitive(class_type->fields, header[1]);
+		if (field == 0 || (field->flag_attributes & clcpp::FlagAttribute::TRANSIENT) != 0)
+			return step;
+
+		step.action = SchemaStep::ACTION_FIELD;
+		step.offset = field->offset;
+		step.field = field;
+		step.load_function = FindCustomFunction(field, load_hash);
+
+		// Decide up-front what loading primitive values would do with the chunk, leaving everything
+		// else to check the chunk as it's loaded
+		if (step.load_function == 0 && field->ci == 0 && field->qualifier.op != clcpp::Qualifier::POINTER)
+		{
+			if (header[0] != field->type->name.hash)
+				step.action = SchemaStep::ACTION_SKIP;
+			else if (field->type->kind == clcpp::Primitive::KIND_TYPE)
+			{
+				step.match_size = true;
+				step.action = header[2] == field->type->size ? SchemaStep::ACTION_COPY : SchemaStep::ACTION_SKIP;
+			}
+		}
+
+		return step;
+	}
+
+
+	void AddPlanSteps(GrowArray<SchemaStep>& steps, const ClassPlan* plan, unsigned int nb_ops)
+	{
+		// Describe the chunks loaded by following the plan in terms of schema steps
+		for (unsigned int i = 0; i < nb_ops; i++)
+		{
+			const PlanOp& op = plan->ops[i];
+			SchemaStep step;
+			if (op.kind == PlanOp::KIND_RUN)
+			{
+				for (unsigned int j = 0; j < op.nb_slots; j++)
+				{
+					const PlanSlot& slot = plan->slots[op.first_slot + j];
+					memcpy(step.header, slot.header, sizeof(step.header));
+					step.match_size = true;
+					step.action = SchemaStep::ACTION_COPY;
+					step.offset = slot.offset;
+					steps.Add(step);
+				}
+			}
+			else
+			{
+				step.header[0] = op.type_hash;
+				step.header[1] = op.field->name.hash;
+				step.action = SchemaStep::ACTION_FIELD;
+				step.offset = op.field->offset;
+				step.field = op.field;
+				step.load_function = op.load_function;
+				steps.Add(step);
+			}
+		}
+	}
+
+
+	void LoadSchemaStep(clutl::ReadBuffer& in, char* object, const SchemaStep& step, unsigned int data_size, LoadContext& ctx)
+	{
+		switch (step.action)
+		{
+		case (SchemaStep::ACTION_SKIP):
+			in.SeekRel(data_size);
+			break;
+
+		case (SchemaStep::ACTION_COPY):
+			in.Read(object + step.offset, data_size);
+			break;
+
+		case (SchemaStep::ACTION_FIELD):
+		{
+			ChunkHeader header(step.header[0], step.header[1]);
+			header.data_size = data_size;
+			LoadClassField(in, object + step.offset, step.field, step.load_function, header, ctx);
+			break;
+		}
+		}
+	}
+
+
+	unsigned int FollowSchema(clutl::ReadBuffer& in, char* object, const ClassPlan* plan, unsigned int end_pos, LoadContext& ctx)
+	{
+		// Load chunks for as long as their headers match the schema, returning how many did
+		const unsigned int header_size = sizeof(unsigned int) * 3;
+		unsigned int nb_steps = 0;
+		for (; nb_steps < plan->schema.GetSize(); nb_steps++)
+		{
+			unsigned int position = in.GetBytesRead();
+			if (position + header_size > end_pos)
+				break;
+			unsigned int header[3];
+			memcpy(header, in.ReadAt(position), sizeof(header));
+			const SchemaStep& step = plan->schema[nb_steps];
+			if (header[0] != step.header[0] || header[1] != step.header[1] || (step.match_size && header[2] != step.header[2]))
+				break;
+			if (header[2] > end_pos - position - header_size)
+				break;
+
+			in.SeekRel(header_size);
+			LoadSchemaStep(in, object, step, header[2], ctx);
+		}
+
+		return nb_steps;
+	}
+
+
+	void MapStreamClass(const ClassPlan* plan, const clcpp::Class* class_type, LoadContext& ctx)
 	{
-		unsigned int end_pos = in.GetBytesRead() + data_size;
+		plan->loaded_stream_id = ctx.stream_id;
+		plan->stream_steps.Clear();
+
+		// Each class in the field table is its name hash and field count, followed by the type hash,
+		// name hash and fixed size of each field
+		const char* data = ctx.table;
+		const char* end = ctx.table + ctx.table_size;
+		while (end - data >= (int)sizeof(unsigned int))
+		{
+			unsigned int class_hash;
+			memcpy(&class_hash, data, sizeof(class_hash));
+			data += sizeof(class_hash);
+			unsigned int nb_fields = DecodeVarint(data, end);
 
-		ContainerChunkHeader header(in);
+			// Map each field of the class to what's done with its data, skipping the fields of other classes
+			for (unsigned int i = 0; i < nb_fields && end - data >= (int)sizeof(unsigned int) * 2; i++)
+			{
+				unsigned int header[3];
+				memcpy(header, data, sizeof(unsigned int) * 2);
+				data += sizeof(unsigned int) * 2;
+				header[2] = DecodeVarint(data, end);
+				if (class_hash == plan->class_hash)
+					plan->stream_steps.Add(MapChunk(header, class_type));
+			}
 
-		// Check array ranges
-		unsigned int count = header.count;
-		if (expected_count > count)
-		{
-			// This is fine, there's less data to load than storage space available
-			// TODO: Warning?
-		}
-		else if (expected_count < count)
-		{
-			// This is not fine, there's more data to load than storage space available
-			// Load as much as possible
-			// TODO: Warning
-			count = expected_count;
+			if (class_hash == plan->class_hash)
+				break;
 		}
+	}
 
-		// Ensure value types match
-		if (header.value_type_hash != writer.m_ValueType->name.hash)
-		{
-			// TODO: Warning
-			in.SeekRel(data_size);
-			return;
-		}
 
-		for (unsigned int i = 0; i < count; i++)
+	void LoadCompactClass(clutl::ReadBuffer& in, char* object, const clcpp::Class* class_type, const ClassPlan* plan, unsigned int data_size, LoadContext& ctx)
+	{
+		const char* data = in.ReadAt(in.GetBytesRead());
+		const char* end = in.ReadAt(in.GetBytesRead() + data_size);
+		while (data < end)
 		{
-			char* container_object = (char*)writer.AddEmpty();
-
-			// Check to see if this is a value type that may be variable size
-			unsigned int value_type_size = header.value_type_size;
-			if (value_type_size == 0)
-				in.Read(&value_type_size, sizeof(value_type_size));
+			// Map the field table of the class on first use in this stream, checking before each field in
+			// case a custom load function has since loaded the class from another stream
+			if (plan->loaded_stream_id != ctx.stream_id)
+				MapStreamClass(plan, class_type, ctx);
+
+			// Fields without a table entry can't be skipped so give up on the rest of the class
+			unsigned int index = DecodeVarint(data, end);
+			if (index >= plan->stream_steps.GetSize())
+				break;
+			const SchemaStep& step = plan->stream_steps[index];
 
-			if (writer.m_ValueIsPtr)
-			{
-				// Ask the user if they want to save this pointer
-				//void* ptr = *(void**)kv.value;
-				//if (ptr_save == 0 || !ptr_save->CanSavePtr(ptr, field, reader.m_ValueType))
-				//	continue;
+			// Fields are only followed by their size if it varies
+			unsigned int field_size = step.header[2];
+			if (field_size == 0)
+				field_size = DecodeVarint(data, end);
+			if (field_size > (unsigned int)(end - data))
+				break;
 
-				//SavePtr(out, kv.value, ptr_save, flags);
-			}
-			else
+			// Primitive values are copied straight out of the data
+			if (step.action == SchemaStep::ACTION_COPY)
 			{
-				LoadObject(in, container_object, writer.m_ValueType, value_type_size, header.value_type_hash);
+				memcpy(object + step.offset, data, field_size);
+				data += field_size;
+				continue;
 			}
+
+			// Anything else is loaded from the read buffer, copying the step in case loading the field
+			// maps this class for another stream
+			SchemaStep field_step = step;
+			in.SeekRel(data - in.ReadAt(in.GetBytesRead()));
+			LoadSchemaStep(in, object, field_step, field_size, ctx);
+			data = in.ReadAt(in.GetBytesRead());
 		}
 
-		int bytes_left = end_pos - in.GetBytesRead();
-		if (bytes_left > 0)
+		// Continue after the class, wherever loading it stopped
+		in.SeekRel(end - in.ReadAt(in.GetBytesRead()));
+	}
+
+
+	const char* FindSnapshotLayout(LoadContext& ctx, unsigned int fingerprint, unsigned int& nb_leaves)
+	{
+		// Each layout is its fingerprint and leaf count, followed by the leaves
+		const unsigned int leaf_size = sizeof(unsigned int) * 5;
+		unsigned int position = 0;
+		while (position + sizeof(unsigned int) * 2 <= ctx.table_size)
 		{
-			if (header.count != count)
+			unsigned int header[2];
+			memcpy(header, ctx.table + position, sizeof(header));
+			position += sizeof(header);
+			if (header[0] == fingerprint)
 			{
-				// Skip over remaining data for when expected_count < count
-				in.SeekRel(bytes_left);
+				nb_leaves = header[1];
+				return position + nb_leaves * leaf_size <= ctx.table_size ? ctx.table + position : 0;
 			}
+			position += header[1] * leaf_size;
+		}
 
-			else
+		return 0;
+	}
+
+
+	void LoadRawClass(clutl::ReadBuffer& in, char* object, const ClassPlan* plan, unsigned int fingerprint, unsigned int data_size, LoadContext& ctx)
+	{
+		const char* data = in.ReadAt(in.GetBytesRead());
+		unsigned int nb_leaves = 0;
+		const char* leaves = 0;
+
+		// Saved by a build with the same layout so copy each run of memory straight back
+		if (fingerprint == plan->fingerprint && plan->is_raw && data_size == plan->raw_size)
+		{
+			for (unsigned int i = 0; i < plan->runs.GetSize(); i++)
 			{
-				// ERROR: Lower levels should catch and correct underflow
-				// Assert?
+				const RawRun& run = plan->runs[i];
+				memcpy(object + run.offset, data, run.size);
+				data += run.size;
 			}
 		}
-		else if (bytes_left < 0)
+
+		// Otherwise use the saved layout to find values that still exist at the same path with the
+		// same type, loading as many array elements as there's room for
+		else if ((leaves = FindSnapshotLayout(ctx, fingerprint, nb_leaves)) != 0)
 		{
-			// ERROR: Lower levels should catch and correct overflow
-			// Assert?
-		}
-	}
+			for (unsigned int i = 0; i < nb_leaves; i++)
+			{
+				// Path hash, type hash, data offset, size and count
+				unsigned int leaf[5];
+				memcpy(leaf, leaves + i * sizeof(leaf), sizeof(leaf));
+				if (leaf[2] + leaf[3] * leaf[4] > data_size)
+					continue;
 
+				for (unsigned int j = 0; j < plan->leaves.GetSize(); j++)
+				{
+					const LayoutLeaf& dest_leaf = plan->leaves[j];
+					if (dest_leaf.path_hash == leaf[0])
+					{
+						if (dest_leaf.type_hash == leaf[1] && dest_leaf.size == leaf[3])
+						{
+							unsigned int count = dest_leaf.count < leaf[4] ? dest_leaf.count : leaf[4];
+							memcpy(object + dest_leaf.offset, data + leaf[2], dest_leaf.size * count);
+						}
+						break;
+					}
+				}
+			}
+		}
 
-	void LoadFieldArray(clutl::ReadBuffer& in, char* object, const clcpp::Field* field, unsigned int data_size)
-	{
-		// Create an array write iterator
-		clcpp::WriteIterator writer;
-		writer.Initialise(field, object);
-		LoadContainer(in, writer, data_size, field->ci->count);
+		in.SeekRel(data_size);
 	}
 
 
-	void LoadClassField(clutl::ReadBuffer& in, char* object, const clcpp::Class* class_type)
+	void LoadClass(clutl::ReadBuffer& in, char* object, const clcpp::Class* class_type, unsigned int data_size, LoadContext& ctx)
 	{
-		// Read the header and skip the chunk if the field doesn't exist or its destination is transient
-		ChunkHeader header(in);
-		const clcpp::Field* field = clcpp::FindPrimitive(class_type->fields, header.name_hash);
-		if (field == 0 || (field->flag_attributes & clcpp::FlagAttribute::TRANSIENT) != 0)
+		const ClassPlan* plan = GetClassPlan(ctx.plans, class_type);
+
+		if (ctx.format == FORMAT_COMPACT)
 		{
-			in.SeekRel(header.data_size);
+			LoadCompactClass(in, object, class_type, plan, data_size, ctx);
 			return;
 		}
-		char* field_object = object + field->offset;
 
-		// Is there a custom load function for this field?
-		// TODO: Flag for marking custom loads on a field
-		if (field->attributes.size != 0)
+		// Snapshots lead with the fingerprint of the class layout if it was saved raw
+		if (ctx.format == FORMAT_SNAPSHOT)
 		{
-			static unsigned int hash = clcpp::internal::HashNameString("load_vbin");			
-			if (const clcpp::Attribute* attr = clcpp::FindPrimitive(field->attributes, hash))
+			unsigned int fingerprint = 0;
+			if (data_size < sizeof(fingerprint))
 			{
-				int end_pos = in.GetBytesRead() + header.data_size;
-
-				// Call the function to read the data
-				const clcpp::PrimitiveAttribute* name_attr = attr->AsPrimitiveAttribute();
-				clcpp::CallFunction((clcpp::Function*)name_attr->primitive, clcpp::ByRef(in), field_object);
-
-				// Correct any read errors in the custom function
-				int position = in.GetBytesRead();
-				if (position < end_pos)
-				{
-					// TODO: Warning, not enough data read by custom reader
-					in.SeekRel(end_pos - position);
-				}
-				else if (position > end_pos)
-				{
-					// TODO: Warning, too much data read by custom reader
-					in.SeekRel(end_pos - position);
-				}
-
+				in.SeekRel(data_size);
+				return;
+			}
+			in.Read(&fingerprint, sizeof(fingerprint));
+			data_size -= sizeof(fingerprint);
+			if (fingerprint != 0)
+			{
+				LoadRawClass(in, object, plan, fingerprint, data_size, ctx);
 				return;
 			}
 		}
 
-		if (field->ci != 0)
-		{
-			// TODO: What happens if counts differ?
-			LoadFieldArray(in, field_object, field, header.data_size);
-		}
-		else
+		unsigned int end_pos = in.GetBytesRead() + data_size;
+		plan->load_depth++;
+
+		// Data saved with an older class layout that's been seen before follows the schema mapped from
+		// it, until its chunks stop matching
+		unsigned int nb_steps = 0;
+		if (plan->schema.GetSize() != 0)
 		{
-			LoadObject(in, field_object, field->type, header.data_size, header.type_hash);
+			nb_steps = FollowSchema(in, object, plan, end_pos, ctx);
+			if (nb_steps == plan->schema.GetSize() && in.GetBytesRead() == end_pos)
+			{
+				plan->load_depth--;
+				return;
+			}
 		}
-	}
 
+		// The steps of any new schema start with those already followed
+		GrowArray<SchemaStep> steps;
+		for (unsigned int i = 0; i < nb_steps; i++)
+			steps.Add(plan->schema[i]);
+		bool mapping = nb_steps != 0;
 
-	void LoadClass(clutl::ReadBuffer& in, char* object, const clcpp::Class* class_type, unsigned int data_size)
-	{
 		// Loop until all the data for this class has been read
-		unsigned int end_pos = in.GetBytesRead() + data_size;
+		const unsigned int header_size = sizeof(unsigned int) * 3;
+		unsigned int op_index = 0;
 		while (in.GetBytesRead() < end_pos)
 		{
-			LoadClassField(in, object, class_type);
+			// Data saved with the same class layout follows the plan, skipping the search for each field
+			if (!mapping && op_index < plan->ops.GetSize())
+			{
+				const PlanOp& op = plan->ops[op_index];
+				bool loaded = op.kind == PlanOp::KIND_RUN ?
+					LoadRun(in, object, plan, op, end_pos) :
+					LoadPlanField(in, object, op, end_pos, ctx);
+				if (loaded)
+				{
+					op_index++;
+					continue;
+				}
+			}
+
+			// Otherwise, such as for fields that have since been removed, look the field up by name and
+			// record what was done with it for the next object
+			if (!mapping)
+			{
+				AddPlanSteps(steps, plan, op_index);
+				mapping = true;
+			}
+			if (in.GetBytesRead() + header_size > end_pos)
+			{
+				in.SeekRel(end_pos - in.GetBytesRead());
+				break;
+			}
+			unsigned int header[3];
+			memcpy(header, in.ReadAt(in.GetBytesRead()), sizeof(header));
+			SchemaStep step = MapChunk(header, class_type);
+			steps.Add(step);
+			in.SeekRel(header_size);
+			LoadSchemaStep(in, object, step, header[2], ctx);
+		}
+
+		// Keep the schema if all of the class was mapped
+		if (mapping && plan->load_depth == 1 && in.GetBytesRead() == end_pos)
+		{
+			plan->schema.Clear();
+			for (unsigned int i = 0; i < steps.GetSize(); i++)
+				plan->schema.Add(steps[i]);
 		}
+		plan->load_depth--;
 
 		if (in.GetBytesRead() != end_pos)
 		{
@@ -482,7 +2132,7 @@ namespace
 	}
 
 
-	void LoadObject(clutl::ReadBuffer& in, char* object, const clcpp::Type* type, unsigned int data_size, unsigned int type_hash)
+	void LoadObject(clutl::ReadBuffer& in, char* object, const clcpp::Type* type, unsigned int data_size, unsigned int type_hash, LoadContext& ctx)
 	{
 		// If the header type doesn't match the expected type, skip this object
 		// TODO: If types are not equal, are they convertible?
@@ -503,7 +2153,7 @@ namespace
 			break;
 
 		case (clcpp::Primitive::KIND_CLASS):
-			LoadClass(in, object, type->AsClass(), data_size);
+			LoadClass(in, object, type->AsClass(), data_size, ctx);
 			break;
 
 		default:
@@ -511,19 +2161,395 @@ namespace
 			clcpp::internal::Assert(false);
 		}
 	}
+
+
+	void LoadObjectTable(clutl::ReadBuffer& in, LoadContext& ctx)
+	{
+		// Only objects saved with pointers are followed by an object table
+		const unsigned int header_size = sizeof(unsigned int) * 3;
+		if (in.GetBytesRemaining() < header_size)
+			return;
+		ChunkHeader header(in);
+		if (header.type_hash != GetObjectTableHash() || header.name_hash != 0)
+		{
+			in.SeekRel(-(int)header_size);
+			return;
+		}
+
+		if (ctx.ptr_load == 0)
+		{
+			in.SeekRel(header.data_size);
+			return;
+		}
+
+		// Create and load each object in the order they were referenced
+		unsigned int end_pos = in.GetBytesRead() + header.data_size;
+		while (in.GetBytesRead() < end_pos)
+		{
+			ChunkHeader object_header(in);
+			const clcpp::Type* type = ctx.ptr_load->GetPtrType(object_header.type_hash);
+			void* object = type != 0 ? ctx.ptr_load->CreatePtr(type) : 0;
+			if (object != 0)
+				LoadObject(in, (char*)object, type, object_header.data_size, object_header.type_hash, ctx);
+			else
+				in.SeekRel(object_header.data_size);
+
+			ctx.objects.Add(object);
+		}
+	}
+
+
+	void PatchPtrs(LoadContext& ctx)
+	{
+		// References to objects that couldn't be created are left null
+		for (unsigned int i = 0; i < ctx.patches.GetSize(); i++)
+		{
+			PtrPatch& patch = ctx.patches[i];
+			*patch.ptr = patch.ref <= ctx.objects.GetSize() ? ctx.objects[patch.ref - 1] : 0;
+		}
+	}
+
+
+	void SaveGraph(clutl::WriteBuffer& out, const void* object, const clcpp::Type* type, SaveContext& ctx)
+	{
+		// The object being saved is the first in the graph so that pointers back to it are restored
+		if (ctx.ptr_save != 0)
+		{
+			ctx.objects.Add(PtrObject(object, type));
+			ctx.object_refs.Add(object, 1, type);
+		}
+
+		if (ctx.format == FORMAT_COMPACT)
+			SaveCompactObject(out, PtrObject(object, type), ctx);
+		else
+		{
+			ChunkHeaderWriter header_writer(out, type->name.hash, 0, ctx.frames);
+			SaveObject(out, (const char*)object, type, ctx);
+		}
+
+		SaveObjectTable(out, ctx);
+	}
+
+
+	void LoadGraph(clutl::ReadBuffer& in, void* object, const clcpp::Type* type, LoadContext& ctx)
+	{
+		if (ctx.ptr_load != 0)
+			ctx.objects.Add(object);
+
+		ChunkHeader header(in);
+		LoadObject(in, (char*)object, type, header.data_size, header.type_hash, ctx);
+
+		// TODO: verify position
+
+		// Load all objects referenced by pointer before pointing to them
+		LoadObjectTable(in, ctx);
+		PatchPtrs(ctx);
+	}
+
+
+	void LoadCompactGraph(clutl::ReadBuffer& in, void* object, const clcpp::Type* type, unsigned int end_pos, LoadContext& ctx)
+	{
+		if (ctx.ptr_load != 0)
+			ctx.objects.Add(object);
+
+		// The object is followed by each object it references, in the order they were first referenced,
+		// all written with their type hash and size
+		for (bool is_root = true; in.GetBytesRead() + sizeof(unsigned int) < end_pos; is_root = false)
+		{
+			unsigned int type_hash;
+			in.Read(&type_hash, sizeof(type_hash));
+			unsigned int data_size = ReadVarint(in);
+			if (in.GetBytesRead() > end_pos || data_size > end_pos - in.GetBytesRead())
+				break;
+
+			if (is_root)
+			{
+				LoadObject(in, (char*)object, type, data_size, type_hash, ctx);
+				continue;
+			}
+
+			// Referenced objects are only created if the user wants them
+			if (ctx.ptr_load == 0)
+				break;
+			const clcpp::Type* ptr_type = ctx.ptr_load->GetPtrType(type_hash);
+			void* ptr = ptr_type != 0 ? ctx.ptr_load->CreatePtr(ptr_type) : 0;
+			if (ptr != 0)
+				LoadObject(in, (char*)ptr, ptr_type, data_size, type_hash, ctx);
+			else
+				in.SeekRel(data_size);
+
+			ctx.objects.Add(ptr);
+		}
+
+		in.SeekRel(end_pos - in.GetBytesRead());
+		PatchPtrs(ctx);
+	}
+
+
+	unsigned int GetStreamedHash()
+	{
+		static const unsigned int hash = CLCPP_NAME_HASH("clutl::StreamedBinary");
+		return hash;
+	}
+
+
+	void SaveStreamedGraph(clutl::WriteBuffer& out, const void* object, const clcpp::Type* type, SaveContext& ctx)
+	{
+		// Streamed graphs are identified by a leading hash and split into frames of up to half the
+		// buffer's capacity, so that closed frames can be flushed while the open one fills
+		unsigned int stream_hash = GetStreamedHash();
+		out.Write(&stream_hash, sizeof(stream_hash));
+		unsigned int frame_size = out.GetBytesAllocated() / 2;
+		if (frame_size < 256)
+			frame_size = 256;
+
+		FrameWriter frames(out, frame_size);
+		ctx.frames = &frames;
+		SaveGraph(out, object, type, ctx);
+		frames.Finish();
+		ctx.frames = 0;
+	}
+
+
+	bool LoadStreamedGraph(clutl::ReadBuffer& in, void* object, const clcpp::Type* type, LoadContext& ctx)
+	{
+		// Leave the data untouched if it doesn't start with the hash
+		unsigned int stream_hash;
+		if (in.GetBytesRemaining() < sizeof(stream_hash))
+			return false;
+		memcpy(&stream_hash, in.ReadAt(in.GetBytesRead()), sizeof(stream_hash));
+		if (stream_hash != GetStreamedHash())
+			return false;
+		in.SeekRel(sizeof(stream_hash));
+
+		// Join the data of each frame, writing in the chunk sizes that follow it
+		clutl::WriteBuffer joined;
+		while (true)
+		{
+			// Give up on the graph if any frame is cut short
+			unsigned int frame_size = 0, nb_fixups = 0;
+			if (in.GetBytesRemaining() < sizeof(frame_size))
+				return true;
+			in.Read(&frame_size, sizeof(frame_size));
+			if (frame_size == FrameWriter::END)
+				break;
+			if (frame_size > in.GetBytesRemaining() || in.GetBytesRemaining() - frame_size < sizeof(nb_fixups))
+				return true;
+			joined.Write(in.ReadAt(in.GetBytesRead()), frame_size);
+			in.SeekRel(frame_size);
+
+			in.Read(&nb_fixups, sizeof(nb_fixups));
+			if (nb_fixups > in.GetBytesRemaining() / sizeof(SizeFixup))
+				return true;
+			for (unsigned int i = 0; i < nb_fixups; i++)
+			{
+				SizeFixup fixup;
+				in.Read(&fixup, sizeof(fixup));
+				if (fixup.position < joined.GetBytesWritten() && joined.GetBytesWritten() - fixup.position >= sizeof(fixup.size))
+					memcpy(joined.GetDataAt(fixup.position), &fixup.size, sizeof(fixup.size));
+			}
+		}
+
+		if (joined.GetBytesWritten() != 0)
+		{
+			clutl::ReadBuffer joined_in(joined);
+			LoadGraph(joined_in, object, type, ctx);
+		}
+		return true;
+	}
+
+
+	unsigned int GetSnapshotHash()
+	{
+		static const unsigned int hash = CLCPP_NAME_HASH("clutl::Snapshot");
+		return hash;
+	}
+
+
+	unsigned int GetCompactHash()
+	{
+		static const unsigned int hash = CLCPP_NAME_HASH("clutl::CompactBinary");
+		return hash;
+	}
+
+
+	void SaveLayoutTable(clutl::WriteBuffer& out, SaveContext& ctx)
+	{
+		// The fingerprint and leaf count of each class layout are followed by its leaves
+		for (unsigned int i = 0; i < ctx.stream_plans.GetSize(); i++)
+		{
+			const ClassPlan* plan = ctx.stream_plans[i];
+			unsigned int header[] = { plan->fingerprint, plan->leaves.GetSize() };
+			out.Write(header, sizeof(header));
+			for (unsigned int j = 0; j < plan->leaves.GetSize(); j++)
+			{
+				const LayoutLeaf& leaf = plan->leaves[j];
+				unsigned int values[] = { leaf.path_hash, leaf.type_hash, leaf.data_offset, leaf.size, leaf.count };
+				out.Write(values, sizeof(values));
+			}
+		}
+	}
+
+
+	void SaveFieldTable(clutl::WriteBuffer& out, SaveContext& ctx)
+	{
+		// The name hash and field count of each class are followed by the type hash, name hash and fixed
+		// size of each field
+		for (unsigned int i = 0; i < ctx.stream_plans.GetSize(); i++)
+		{
+			const ClassPlan* plan = ctx.stream_plans[i];
+			out.Write(&plan->class_hash, sizeof(plan->class_hash));
+			WriteVarint(out, plan->table_fields.GetSize());
+			for (unsigned int j = 0; j < plan->table_fields.GetSize(); j++)
+			{
+				const PlanSlot& field = plan->table_fields[j];
+				out.Write(field.header, sizeof(unsigned int) * 2);
+				WriteVarint(out, field.header[2]);
+			}
+		}
+	}
+
+
+	void SaveStream(clutl::WriteBuffer& out, unsigned int stream_hash, const void* object, const clcpp::Type* type, SaveContext& ctx)
+	{
+		// The graph is followed by a table of the classes it used, sizes of both written before each
+		out.Write(&stream_hash, sizeof(stream_hash));
+		SizeBackPatcher graph_size;
+		graph_size.Mark(out);
+		SaveGraph(out, object, type, ctx);
+		graph_size.Patch(out);
+
+		SizeBackPatcher table_size;
+		table_size.Mark(out);
+		if (ctx.format == FORMAT_COMPACT)
+			SaveFieldTable(out, ctx);
+		else
+			SaveLayoutTable(out, ctx);
+		table_size.Patch(out);
+	}
+
+
+	unsigned int OpenStream(clutl::ReadBuffer& in, unsigned int stream_hash, LoadContext& ctx)
+	{
+		// Leave the data untouched if it doesn't start with the hash
+		const unsigned int header_size = sizeof(unsigned int) * 2;
+		if (in.GetBytesRemaining() < header_size)
+			return 0;
+		unsigned int header[2];
+		memcpy(header, in.ReadAt(in.GetBytesRead()), sizeof(header));
+		if (header[0] != stream_hash || header[1] + sizeof(unsigned int) > in.GetBytesRemaining() - header_size)
+			return 0;
+		in.SeekRel(header_size);
+
+		// Locate the table before loading the graph so that it can be used while loading, returning
+		// where it starts
+		unsigned int table_pos = in.GetBytesRead() + header[1];
+		memcpy(&ctx.table_size, in.ReadAt(table_pos), sizeof(ctx.table_size));
+		table_pos += sizeof(ctx.table_size);
+		if (ctx.table_size > in.GetTotalBytes() - table_pos)
+			ctx.table_size = 0;
+		ctx.table = in.ReadAt(table_pos);
+		return table_pos;
+	}
+}
+
+clutl::VBinPlanCache::VBinPlanCache()
+	: m_Plans(0)
+{
+}
+
+
+clutl::VBinPlanCache::~VBinPlanCache()
+{
+	if (m_Plans != 0)
+		delete m_Plans;
+}
+
+
+clutl::VBinPlans& clutl::VBinPlanCache::GetPlans()
+{
+	if (m_Plans == 0)
+		m_Plans = new VBinPlans;
+	return *m_Plans;
+}
+
+
+void clutl::SaveVersionedBinary(WriteBuffer& out, const void* object, const clcpp::Type* type, IPtrSave* ptr_save, VBinPlanCache* plan_cache, unsigned int flags)
+{
+	// Plans only last for this call if there's no cache to keep them in
+	VBinPlanCache local_plan_cache;
+	if (plan_cache == 0)
+		plan_cache = &local_plan_cache;
+
+	// Compact streams need their whole graph in the buffer to back-patch its size and can't be
+	// split into frames, so a streamed save would silently lose its bounded memory use
+	clcpp::internal::Assert(((flags & VBinFlags::COMPACT) == 0 || (flags & VBinFlags::STREAMED) == 0) &&
+		"VBinFlags::STREAMED can't be combined with VBinFlags::COMPACT");
+
+	// Compact streams are identified by a leading hash and followed by the field table of each class
+	if ((flags & VBinFlags::COMPACT) != 0)
+	{
+		SaveContext ctx(ptr_save, plan_cache->GetPlans(), FORMAT_COMPACT);
+		SaveStream(out, GetCompactHash(), object, type, ctx);
+		return;
+	}
+
+	SaveContext ctx(ptr_save, plan_cache->GetPlans(), FORMAT_VBIN);
+	if ((flags & VBinFlags::STREAMED) != 0)
+		SaveStreamedGraph(out, object, type, ctx);
+	else
+		SaveGraph(out, object, type, ctx);
 }
 
-void clutl::SaveVersionedBinary(WriteBuffer& out, const void* object, const clcpp::Type* type)
+
+void clutl::LoadVersionedBinary(ReadBuffer& in, void* object, const clcpp::Type* type, IPtrLoad* ptr_load, VBinPlanCache* plan_cache)
 {
-	ChunkHeaderWriter header_writer(out, type->name.hash, 0);
-	SaveObject(out, (const char*)object, type);
+	VBinPlanCache local_plan_cache;
+	if (plan_cache == 0)
+		plan_cache = &local_plan_cache;
+
+	// Data without the leading hash of a compact stream uses the original encoding
+	LoadContext ctx(ptr_load, plan_cache->GetPlans(), FORMAT_COMPACT);
+	unsigned int table_pos = OpenStream(in, GetCompactHash(), ctx);
+	if (table_pos == 0)
+	{
+		ctx.format = FORMAT_VBIN;
+		if (!LoadStreamedGraph(in, object, type, ctx))
+			LoadGraph(in, object, type, ctx);
+		return;
+	}
+
+	LoadCompactGraph(in, object, type, table_pos - sizeof(unsigned int), ctx);
+
+	// Continue after the field table
+	in.SeekRel(table_pos + ctx.table_size - in.GetBytesRead());
 }
 
 
-void clutl::LoadVersionedBinary(ReadBuffer& in, void* object, const clcpp::Type* type)
+void clutl::SaveSnapshot(WriteBuffer& out, const void* object, const clcpp::Type* type, IPtrSave* ptr_save, VBinPlanCache* plan_cache)
 {
-	ChunkHeader header(in);
-	LoadObject(in, (char*)object, type, header.data_size, header.type_hash);
+	VBinPlanCache local_plan_cache;
+	if (plan_cache == 0)
+		plan_cache = &local_plan_cache;
 
-	// TODO: verify position
+	SaveContext ctx(ptr_save, plan_cache->GetPlans(), FORMAT_SNAPSHOT);
+	SaveStream(out, GetSnapshotHash(), object, type, ctx);
+}
+
+
+void clutl::LoadSnapshot(ReadBuffer& in, void* object, const clcpp::Type* type, IPtrLoad* ptr_load, VBinPlanCache* plan_cache)
+{
+	VBinPlanCache local_plan_cache;
+	if (plan_cache == 0)
+		plan_cache = &local_plan_cache;
+
+	// Leave the data untouched if it's not a snapshot, otherwise using its layout table if layouts differ
+	LoadContext ctx(ptr_load, plan_cache->GetPlans(), FORMAT_SNAPSHOT);
+	unsigned int table_pos = OpenStream(in, GetSnapshotHash(), ctx);
+	if (table_pos == 0)
+		return;
+	LoadGraph(in, object, type, ctx);
+
+	// Continue after the layout table
+	in.SeekRel(table_pos + ctx.table_size - in.GetBytesRead());
 }
\ No newline at end of file